@@ -0,0 +1,655 @@
+#include "regex_dfa.h"
+#include <cstdlib>
+#include <new>
+#include <malloc.h>
+#include <regex>
+
+using namespace std;
+
+// flqn1.cpp's engine, kept as the baseline the families suite compares
+// against. Its headers are already included above, so their include
+// guards keep them out of the namespace and only its classes end up in
+// it. Any header added to flqn1.cpp must also be included above.
+namespace flqn1 {
+#define main flqn1Main
+#include "flqn1.cpp"
+#undef main
+}
+
+// Heap accounting for the peak-memory column: every allocation made
+// through operator new is counted at its usable size.
+static atomic<size_t> heapInUse(0);
+static atomic<size_t> heapPeak(0);
+
+void* operator new(size_t size) {
+    void* ptr = malloc(size ? size : 1);
+    if (!ptr) throw bad_alloc();
+    size_t inUse = heapInUse += malloc_usable_size(ptr);
+    size_t peak = heapPeak.load(memory_order_relaxed);
+    while (inUse > peak && !heapPeak.compare_exchange_weak(peak, inUse)) {}
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    heapInUse -= malloc_usable_size(ptr);
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+// Written once per case so the validate loops cannot be optimized away
+static volatile size_t benchSink;
+
+// One parameterized pattern and the inputs its validate() throughput is
+// measured on
+struct BenchCase {
+    string family;
+    int param;
+    string regex;
+    vector<string> inputs;
+};
+
+struct BenchResult {
+    BenchCase* benchCase;
+    size_t nfaStates = 0;
+    size_t dfaStates = 0;
+    size_t minimizedStates = 0;
+    double convertMs = 0;
+    double minimizeMs = 0;
+    size_t peakBytes = 0;
+    double validateMBps = 0;
+    
+    // flqn1.cpp on the same pattern; left negative when skipped
+    double baselineConvertMs = -1;
+    double baselineMBps = -1;
+};
+
+// Mean wall time of f() over as many runs as fit in minSeconds
+template <typename F>
+double secondsPerRun(F f, double minSeconds = 0.2) {
+    int runs = 0;
+    auto begin = chrono::steady_clock::now();
+    auto now = begin;
+    do {
+        f();
+        runs++;
+        now = chrono::steady_clock::now();
+    } while (chrono::duration<double>(now - begin).count() < minSeconds);
+    return chrono::duration<double>(now - begin).count() / runs;
+}
+
+class RandomText {
+public:
+    explicit RandomText(unsigned seed) : seed(seed) {}
+    
+    unsigned below(unsigned n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % n;
+    }
+    
+    string over(const string& alphabet, size_t length) {
+        string text(length, 0);
+        for (char& c : text) c = alphabet[below(alphabet.size())];
+        return text;
+    }
+    
+private:
+    unsigned seed;
+};
+
+// Random walk over the minimized DFA. Every state of a minimized DFA can
+// still reach acceptance, so the walk never falls into a dead end.
+string randomWalk(const string& regex, size_t length, RandomText& random) {
+    RegexToDFA converter;
+    DFA dfa = converter.convert(regex).minimize();
+    string text;
+    text.reserve(length);
+    vector<char> live;
+    int32_t state = dfa.startState;
+    while (text.size() < length) {
+        live.clear();
+        for (char c : dfa.alphabet) {
+            if (dfa.next(state, dfa.classMap[(unsigned char)c]) != DFA::DEAD_STATE) live.push_back(c);
+        }
+        char c = live[random.below(live.size())];
+        text += c;
+        state = dfa.next(state, dfa.classMap[(unsigned char)c]);
+    }
+    return text;
+}
+
+// (a|b)*abb, (0|1)*1(0|1){n}, alternations of n words and n nested stars
+vector<BenchCase> benchFamilies() {
+    const size_t inputBytes = 8 << 20;
+    RandomText random(12345);
+    vector<BenchCase> cases;
+    
+    cases.push_back({"abb", 0, "(a|b)*abb", {random.over("ab", inputBytes)}});
+    
+    for (int n = 2; n <= 14; n += 2) {
+        string regex = "(0|1)*1";
+        for (int i = 0; i < n; i++) regex += "(0|1)";
+        cases.push_back({"kth-from-end", n, regex, {random.over("01", inputBytes)}});
+    }
+    
+    for (int n : {16, 64, 256, 1024}) {
+        BenchCase benchCase{"alternation", n, "", {}};
+        vector<string> words;
+        for (int i = 0; i < n; i++) {
+            words.push_back(random.over("abcdefghijklmnopqrstuvwxyz", 8));
+            benchCase.regex += (i ? "|" : "") + words.back();
+        }
+        // Half of the inputs are words of the alternation, half are not
+        for (size_t bytes = 0; bytes < inputBytes; bytes += 8) {
+            benchCase.inputs.push_back(random.below(2) ? words[random.below(n)]
+                                                       : random.over("abcdefghijklmnopqrstuvwxyz", 8));
+        }
+        cases.push_back(benchCase);
+    }
+    
+    // ((a*b)*c)* and deeper
+    for (int n : {2, 4, 8, 16, 24}) {
+        string regex = "a";
+        for (int i = 1; i <= n; i++) {
+            regex = "(" + regex + "*" + (char)('a' + i) + ")";
+        }
+        regex += "*";
+        cases.push_back({"nested-star", n, regex, {randomWalk(regex, inputBytes, random)}});
+    }
+    return cases;
+}
+
+// Whole-input validation on flqn1's map-based DFA
+bool baselineValidate(flqn1::DFA& dfa, const string& input) {
+    int state = dfa.startState;
+    for (char c : input) {
+        auto row = dfa.transitions.find(state);
+        if (row == dfa.transitions.end()) return false;
+        auto next = row->second.find(c);
+        if (next == row->second.end()) return false;
+        state = next->second;
+    }
+    return dfa.acceptStates.count(state) != 0;
+}
+
+BenchResult runCase(BenchCase& benchCase, bool baseline) {
+    BenchResult result;
+    result.benchCase = &benchCase;
+    RegexToDFA converter;
+    
+    result.nfaStates = converter.toNFA(benchCase.regex).states.size();
+    
+    size_t heapBefore = heapInUse;
+    heapPeak = heapBefore;
+    DFA dfa = converter.convert(benchCase.regex);
+    result.peakBytes = heapPeak - heapBefore;
+    result.dfaStates = dfa.dfaStates.size();
+    
+    DFA minimized = dfa.minimize();
+    result.minimizedStates = minimized.dfaStates.size();
+    result.convertMs = 1e3 * secondsPerRun([&] { converter.convert(benchCase.regex); });
+    result.minimizeMs = 1e3 * secondsPerRun([&] { dfa.minimize(); });
+    
+    size_t bytes = 0;
+    for (const string& input : benchCase.inputs) bytes += input.size();
+    size_t accepted = 0;
+    double seconds = secondsPerRun([&] {
+        for (const string& input : benchCase.inputs) accepted += minimized.validate(input);
+    });
+    result.validateMBps = bytes / 1e6 / seconds;
+    
+    // flqn1 has no limits and std::map tables, so only small DFAs
+    if (baseline && result.dfaStates <= 4096) {
+        flqn1::RegexToDFA baselineConverter;
+        flqn1::DFA baselineDFA;
+        result.baselineConvertMs = 1e3 * secondsPerRun([&] {
+            baselineDFA = baselineConverter.convert(benchCase.regex);
+        });
+        
+        // A slice of the input is enough for a map-walking matcher
+        size_t sliceBytes = 0;
+        size_t sliceEnd = 0;
+        while (sliceEnd < benchCase.inputs.size() && sliceBytes < (1 << 20)) {
+            sliceBytes += min<size_t>(benchCase.inputs[sliceEnd++].size(), 1 << 20);
+        }
+        seconds = secondsPerRun([&] {
+            for (size_t i = 0; i < sliceEnd; i++) {
+                const string& input = benchCase.inputs[i];
+                accepted += baselineValidate(baselineDFA, input.size() > (1 << 20) ? input.substr(0, 1 << 20) : input);
+            }
+        });
+        result.baselineMBps = sliceBytes / 1e6 / seconds;
+    }
+    
+    benchSink = accepted;
+    return result;
+}
+
+string jsonNumber(double value) {
+    if (value < 0) return "null";
+    stringstream ss;
+    ss << fixed << setprecision(3) << value;
+    return ss.str();
+}
+
+// Pattern text is only alphanumerics and operators, so it needs no escaping
+void printFamilies(const vector<BenchResult>& results, const string& format) {
+    if (format == "json") {
+        cout << "[" << endl;
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            cout << "  {\"family\": \"" << r.benchCase->family << "\", \"param\": " << r.benchCase->param
+                 << ", \"regex_length\": " << r.benchCase->regex.size()
+                 << ", \"nfa_states\": " << r.nfaStates
+                 << ", \"dfa_states\": " << r.dfaStates
+                 << ", \"minimized_states\": " << r.minimizedStates
+                 << ", \"convert_ms\": " << jsonNumber(r.convertMs)
+                 << ", \"minimize_ms\": " << jsonNumber(r.minimizeMs)
+                 << ", \"peak_bytes\": " << r.peakBytes
+                 << ", \"validate_mbps\": " << jsonNumber(r.validateMBps)
+                 << ", \"flqn1_convert_ms\": " << jsonNumber(r.baselineConvertMs)
+                 << ", \"flqn1_validate_mbps\": " << jsonNumber(r.baselineMBps) << "}"
+                 << (i + 1 < results.size() ? "," : "") << endl;
+        }
+        cout << "]" << endl;
+        return;
+    }
+    
+    if (format == "csv") {
+        cout << "family,param,regex_length,nfa_states,dfa_states,minimized_states,convert_ms,"
+             << "minimize_ms,peak_bytes,validate_mbps,flqn1_convert_ms,flqn1_validate_mbps" << endl;
+        for (const BenchResult& r : results) {
+            auto optional = [](double value) { return value < 0 ? string() : jsonNumber(value); };
+            cout << r.benchCase->family << "," << r.benchCase->param << "," << r.benchCase->regex.size() << ","
+                 << r.nfaStates << "," << r.dfaStates << "," << r.minimizedStates << ","
+                 << jsonNumber(r.convertMs) << "," << jsonNumber(r.minimizeMs) << ","
+                 << r.peakBytes << "," << jsonNumber(r.validateMBps) << ","
+                 << optional(r.baselineConvertMs) << "," << optional(r.baselineMBps) << endl;
+        }
+        return;
+    }
+    
+    cout << "\nPattern Families Benchmark:" << endl;
+    cout << string(118, '-') << endl;
+    cout << setw(14) << "Family" << setw(6) << "n" << setw(8) << "NFA" << setw(8) << "DFA"
+         << setw(8) << "Min" << setw(12) << "Conv (ms)" << setw(11) << "Min (ms)"
+         << setw(11) << "Peak (KB)" << setw(10) << "MB/s" << setw(16) << "flqn1 conv (ms)"
+         << setw(14) << "flqn1 MB/s" << endl;
+    cout << string(118, '-') << endl;
+    for (const BenchResult& r : results) {
+        cout << setw(14) << r.benchCase->family << setw(6) << r.benchCase->param
+             << setw(8) << r.nfaStates << setw(8) << r.dfaStates << setw(8) << r.minimizedStates
+             << fixed << setprecision(3) << setw(12) << r.convertMs << setw(11) << r.minimizeMs
+             << setw(11) << r.peakBytes / 1024 << setprecision(1) << setw(10) << r.validateMBps;
+        if (r.baselineConvertMs >= 0) {
+            cout << setprecision(3) << setw(16) << r.baselineConvertMs
+                 << setprecision(1) << setw(14) << r.baselineMBps;
+        } else {
+            cout << setw(16) << "-" << setw(14) << "-";
+        }
+        cout << endl;
+    }
+    cout << string(118, '-') << endl;
+}
+
+void benchmarkFamilies(const string& format, bool baseline) {
+    vector<BenchCase> cases = benchFamilies();
+    vector<BenchResult> results;
+    for (BenchCase& benchCase : cases) {
+        results.push_back(runCase(benchCase, baseline));
+    }
+    printFamilies(results, format);
+}
+
+// Times convert() with and without precomputed epsilon closures on the
+// star-heavy demo patterns and on scaled-up versions of them.
+void benchmarkClosures() {
+    vector<string> patterns = {"(a|b)*abb", "a*b*", "(a|b)*", "a(a|b)*b", "(0|1)*1(0|1)(0|1)"};
+    
+    string kth = "(0|1)*1";
+    for (int i = 0; i < 10; i++) kth += "(0|1)";
+    patterns.push_back(kth);
+    
+    string stars;
+    for (int i = 0; i < 40; i++) stars += "(a|b*)*c*";
+    patterns.push_back(stars);
+    
+    cout << "\nEpsilon Closure Benchmark (convert time per pattern):" << endl;
+    cout << string(78, '-') << endl;
+    cout << setw(36) << "Pattern" << " | " << setw(7) << "States" << " | "
+         << setw(11) << "BFS (us)" << " | " << setw(11) << "Precomp (us)" << endl;
+    cout << string(78, '-') << endl;
+    
+    for (const string& pattern : patterns) {
+        double micros[2];
+        size_t states = 0;
+        
+        for (int mode = 0; mode < 2; mode++) {
+            RegexToDFA converter;
+            converter.precomputeClosures = (mode == 1);
+            
+            int reps = 0;
+            auto begin = chrono::steady_clock::now();
+            auto now = begin;
+            do {
+                states = converter.convert(pattern).dfaStates.size();
+                reps++;
+                now = chrono::steady_clock::now();
+            } while (now - begin < chrono::milliseconds(200));
+            micros[mode] = chrono::duration<double, micro>(now - begin).count() / reps;
+        }
+        
+        string shown = pattern.size() > 36 ? pattern.substr(0, 33) + "..." : pattern;
+        cout << setw(36) << shown << " | " << setw(7) << states << " | "
+             << setw(11) << fixed << setprecision(1) << micros[0] << " | "
+             << setw(11) << micros[1] << endl;
+    }
+    cout << string(78, '-') << endl;
+}
+
+// Compares the interleaved batch validate() against one scalar validate()
+// per string over a million short random binary strings, then runs
+// validateBatch() on the same strings at increasing thread counts.
+void benchmarkBatch() {
+    RegexToDFA converter;
+    string regex = "(0|1)*1";
+    for (int i = 0; i < 7; i++) regex += "(0|1)";
+    DFA dfa = converter.convert(regex).minimize();
+    
+    const size_t count = 1000000;
+    vector<string> strings(count);
+    unsigned seed = 12345;
+    size_t totalBytes = 0;
+    for (string& str : strings) {
+        seed = seed * 1103515245 + 12345;
+        size_t length = 8 + (seed >> 16) % 57;
+        for (size_t i = 0; i < length; i++) {
+            seed = seed * 1103515245 + 12345;
+            str += ((seed >> 16) & 1) ? '1' : '0';
+        }
+        totalBytes += length;
+    }
+    vector<string_view> views(strings.begin(), strings.end());
+    unique_ptr<bool[]> scalarResults(new bool[count]);
+    unique_ptr<bool[]> batchResults(new bool[count]);
+    
+    cout << "\nBatch Validation Benchmark: " << regex << ", " << count << " strings, "
+         << dfa.dfaStates.size() << " DFA states" << endl;
+    cout << string(50, '-') << endl;
+    
+    double best[2] = {1e30, 1e30};
+    for (int rep = 0; rep < 5; rep++) {
+        auto begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) scalarResults[i] = dfa.validate(views[i]);
+        auto middle = chrono::steady_clock::now();
+        dfa.validate(views.data(), count, batchResults.get());
+        auto end = chrono::steady_clock::now();
+        
+        best[0] = min(best[0], chrono::duration<double>(middle - begin).count());
+        best[1] = min(best[1], chrono::duration<double>(end - middle).count());
+    }
+    
+    bool same = equal(scalarResults.get(), scalarResults.get() + count, batchResults.get());
+    double mb = totalBytes / 1e6;
+    cout << "  Scalar:      " << fixed << setprecision(1) << setw(8) << mb / best[0] << " MB/s" << endl;
+    cout << "  Interleaved: " << setw(8) << mb / best[1] << " MB/s ("
+         << setprecision(2) << best[0] / best[1] << "x)" << endl;
+    cout << "  Results " << (same ? "match" : "DIFFER") << endl;
+    
+    unsigned maxThreads = max(thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        double seconds = 1e30;
+        BitVector bits;
+        for (int rep = 0; rep < 5; rep++) {
+            auto begin = chrono::steady_clock::now();
+            bits = dfa.validateBatch(views.data(), count, pool);
+            seconds = min(seconds, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+        }
+        bool correct = true;
+        for (size_t i = 0; i < count && correct; i++) correct = bits[i] == scalarResults[i];
+        cout << "  Batch, " << setw(2) << threads << " threads: " << setprecision(1) << setw(8)
+             << mb / seconds << " MB/s" << (correct ? "" : "  (WRONG RESULT)") << endl;
+        if (threads * 2 > maxThreads && threads != maxThreads) threads = maxThreads / 2;
+    }
+}
+
+// Single large input: scalar validate() against validateParallel() at
+// increasing thread counts.
+void benchmarkParallel() {
+    RegexToDFA converter;
+    string regex = "(0|1)*1(0|1)(0|1)";
+    DFA dfa = converter.convert(regex).minimize();
+    
+    string input(256 << 20, '0');
+    unsigned seed = 12345;
+    for (char& c : input) {
+        seed = seed * 1103515245 + 12345;
+        c = ((seed >> 16) & 1) ? '1' : '0';
+    }
+    double mb = input.size() / 1e6;
+    
+    cout << "\nParallel Validation Benchmark: " << regex << ", " << (input.size() >> 20) << " MiB" << endl;
+    cout << string(50, '-') << endl;
+    
+    auto begin = chrono::steady_clock::now();
+    bool expected = dfa.validate(input);
+    double scalar = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    cout << "  Scalar:     " << fixed << setprecision(1) << setw(8) << mb / scalar << " MB/s" << endl;
+    
+    unsigned maxThreads = max(thread::hardware_concurrency(), 1u);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool pool(threads);
+        begin = chrono::steady_clock::now();
+        bool result = dfa.validateParallel(input, pool);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        cout << "  " << setw(2) << threads << " threads: " << setw(8) << mb / seconds << " MB/s"
+             << (result == expected ? "" : "  (WRONG RESULT)") << endl;
+        if (threads * 2 > maxThreads && threads != maxThreads) threads = maxThreads / 2;
+    }
+}
+
+// (0|1)*1(0|1){n} on every engine that can hold it: the table DFA while
+// it is small, then the bit-parallel NFA, lazy DFA and NFA simulation.
+void benchmarkEngines() {
+    string input(16 << 20, '0');
+    unsigned seed = 12345;
+    for (char& c : input) {
+        seed = seed * 1103515245 + 12345;
+        c = ((seed >> 16) & 1) ? '1' : '0';
+    }
+    double mb = input.size() / 1e6;
+    
+    cout << "\nEngine Benchmark: (0|1)*1(0|1){n}, " << (input.size() >> 20) << " MiB" << endl;
+    cout << string(62, '-') << endl;
+    cout << setw(4) << "n" << setw(12) << "DFA" << setw(12) << "Bit-par" << setw(12) << "Lazy"
+         << setw(12) << "NFA sim" << "  (MB/s)   auto" << endl;
+    
+    RegexToDFA converter;
+    for (int n : {4, 8, 12, 16, 20, 24, 28}) {
+        string regex = "(0|1)*1";
+        for (int i = 0; i < n; i++) regex += "(0|1)";
+        bool expected = input[input.size() - n - 1] == '1';
+        
+        auto measure = [&](auto&& validate) {
+            auto begin = chrono::steady_clock::now();
+            bool result = validate(input);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+            return result == expected ? mb / seconds : -1.0;
+        };
+        
+        cout << setw(4) << n << fixed << setprecision(1);
+        if (n <= 12) {
+            DFA dfa = converter.convert(regex).minimize();
+            cout << setw(12) << measure([&](string_view str) { return dfa.validate(str); });
+        } else {
+            cout << setw(12) << "-";
+        }
+        
+        Matcher matcher = converter.convertAuto(regex);
+        BitParallelNFA bitParallel = converter.convertBitParallel(regex);
+        LazyDFA lazy = converter.convertLazy(regex);
+        NFASimulation simulation = converter.convertSimulation(regex);
+        cout << setw(12) << measure([&](string_view str) { return bitParallel.validate(str); })
+             << setw(12) << measure([&](string_view str) { return lazy.validate(str); })
+             << setw(12) << measure([&](string_view str) { return simulation.validate(str); })
+             << "           " << matcher.engineName() << endl;
+    }
+}
+
+// Unanchored search over a synthetic log: every start tried in turn, the
+// literal prefilter, and the reverse DFA from convertSearch() (which
+// defers to the prefilter when there is one).
+void benchmarkSearch() {
+    string log;
+    unsigned seed = 12345;
+    auto random = [&](unsigned n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % n;
+    };
+    while (log.size() < (32 << 20)) {
+        log += random(1000) == 0 ? "error " : "info ";
+        for (unsigned i = 0, n = 20 + random(60); i < n; i++) {
+            log += "abcdefghijklmnopqrstuvwxyz0123456789 "[random(37)];
+        }
+        log += '\n';
+    }
+    double mb = log.size() / 1e6;
+    
+    cout << "\nSearch Benchmark: " << (log.size() >> 20) << " MiB log" << endl;
+    cout << string(50, '-') << endl;
+    
+    RegexToDFA converter;
+    vector<string> patterns = {"error(0|1|2|3|4|5|6|7|8|9)*", "x(0|1)*yz", "(0|1)(0|1)(0|1)zz",
+                               "[a-f]+[0-9]{3}", "e[a-z0-9 ]*q"};
+    for (const string& pattern : patterns) {
+        DFA dfa = converter.convert(pattern).minimize();
+        DFA plain = dfa;
+        plain.prefilter = Prefilter();
+        DFA reverse = converter.convertSearch(pattern).minimize();
+        
+        double seconds[3];
+        size_t found[3];
+        const DFA* engines[3] = {&plain, &dfa, &reverse};
+        for (int e = 0; e < 3; e++) {
+            auto begin = chrono::steady_clock::now();
+            found[e] = engines[e]->findAll(log).size();
+            seconds[e] = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        }
+        
+        cout << "  " << pattern << " (prefix \"" << dfa.prefilter.prefix << "\", factor \""
+             << dfa.prefilter.required << "\"): " << found[1] << " matches" << endl;
+        cout << "    DFA only:  " << fixed << setprecision(1) << setw(8) << mb / seconds[0] << " MB/s" << endl;
+        cout << "    Prefilter: " << setw(8) << mb / seconds[1] << " MB/s ("
+             << setprecision(2) << seconds[0] / seconds[1] << "x)"
+             << (found[0] == found[1] ? "" : "  (WRONG RESULT)") << endl;
+        cout << "    Reverse:   " << setprecision(1) << setw(8) << mb / seconds[2] << " MB/s ("
+             << setprecision(2) << seconds[0] / seconds[2] << "x)"
+             << (found[0] == found[2] ? "" : "  (WRONG RESULT)") << endl;
+    }
+}
+
+// Lexer over generated assignment statements, against a std::regex
+// tokenizer with the same rules on a slice of the input.
+void benchmarkLexer() {
+    enum { IDENTIFIER, NUMBER, OPERATOR };
+    Lexer lexer({
+        {IDENTIFIER, "[A-Za-z_][A-Za-z0-9_]*"},
+        {NUMBER, "[0-9]+"},
+        {OPERATOR, "[-+*/()\\=]"},
+        {Lexer::SKIP, "[ \t\n]+"},
+    });
+    
+    string source;
+    unsigned seed = 12345;
+    auto random = [&](unsigned n) {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % n;
+    };
+    auto identifier = [&]() {
+        string name(1, "abcdefghijklmnopqrstuvwxyz_"[random(27)]);
+        for (unsigned i = 0, n = random(8); i < n; i++) name += "abcdefghijklmnopqrstuvwxyz0123456789_"[random(37)];
+        return name;
+    };
+    while (source.size() < (16 << 20)) {
+        source += identifier() + " = ";
+        for (unsigned i = 0, n = 1 + random(6); i < n; i++) {
+            source += random(2) ? identifier() : to_string(random(100000));
+            source += i + 1 < n ? string(" ") + "+-*/"[random(4)] + " " : "\n";
+        }
+    }
+    double mb = source.size() / 1e6;
+    
+    cout << "\nLexer Benchmark: " << (source.size() >> 20) << " MiB of assignments, "
+         << lexer.states() << " DFA states" << endl;
+    cout << string(50, '-') << endl;
+    
+    vector<Token> tokens;
+    double seconds = 1e30;
+    for (int rep = 0; rep < 3; rep++) {
+        tokens.clear();
+        auto begin = chrono::steady_clock::now();
+        lexer.tokenize(source, tokens);
+        seconds = min(seconds, chrono::duration<double>(chrono::steady_clock::now() - begin).count());
+    }
+    cout << "  Lexer:      " << fixed << setprecision(1) << setw(8) << mb / seconds << " MB/s, "
+         << setprecision(1) << tokens.size() / seconds / 1e6 << "M tokens/s" << endl;
+    
+    string slice = source.substr(0, 1 << 20);
+    slice = slice.substr(0, slice.rfind('\n') + 1);
+    regex rules(R"(([A-Za-z_][A-Za-z0-9_]*)|([0-9]+)|([-+*/()=])|[ \t\n]+)");
+    size_t regexTokens = 0;
+    auto begin = chrono::steady_clock::now();
+    for (sregex_iterator it(slice.begin(), slice.end(), rules), end; it != end; ++it) {
+        if (!(*it)[0].str().empty() && !isspace((unsigned char)(*it)[0].str()[0])) regexTokens++;
+    }
+    double regexSeconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    size_t lexerTokens = lexer.tokenize(slice).size();
+    cout << "  std::regex: " << setw(8) << slice.size() / 1e6 / regexSeconds << " MB/s"
+         << (regexTokens == lexerTokens ? "" : "  (WRONG RESULT)") << endl;
+}
+
+int main(int argc, char* argv[]) {
+    string format = "table";
+    bool baseline = true;
+    vector<string> suites;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--json") format = "json";
+        else if (arg == "--csv") format = "csv";
+        else if (arg == "--no-baseline") baseline = false;
+        else suites.push_back(arg);
+    }
+    if (suites.empty()) suites.push_back("families");
+    
+    for (const string& suite : suites) {
+        if (suite == "families") benchmarkFamilies(format, baseline);
+        else if (suite == "closure") benchmarkClosures();
+        else if (suite == "batch") benchmarkBatch();
+        else if (suite == "parallel") benchmarkParallel();
+        else if (suite == "engines") benchmarkEngines();
+        else if (suite == "search") benchmarkSearch();
+        else if (suite == "lexer") benchmarkLexer();
+        else {
+            cerr << "Usage: " << argv[0] << " [--json|--csv] [--no-baseline] "
+                 << "[families|closure|batch|parallel|engines|search|lexer]..." << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -51,6 +51,12 @@ public:
     }
 };
 
+// Sub-automaton inside an NFA arena, referenced by its entry and exit states
+struct Fragment {
+    int start;
+    int accept;
+};
+
 // DFA
 class DFA {
 public:
@@ -141,204 +147,134 @@ private:
         return result;
     }
     
-    // Thompson's construction for basic regex patterns
-    NFA charNFA(char c) {
-        NFA nfa;
+    // Thompson's construction for basic regex patterns, on a single state
+    // arena: each operator links existing fragments by their (start, accept)
+    // handles and adds at most two states, so no sub-automaton is copied.
+    Fragment charNFA(NFA& nfa, char c) {
         int start = nfa.addState();
         int end = nfa.addState();
         nfa.addTransition(start, c, end);
-        nfa.startState = start;
-        nfa.setAccepting(end);
-        return nfa;
+        return {start, end};
     }
     
-    NFA concatenate(NFA nfa1, NFA nfa2) {
-        NFA result = nfa1;
-        
-        // Add nfa2 states to result
-        int offset = result.states.size();
-        for (const auto& state : nfa2.states) {
-            result.addState();
-        }
-        
-        // Copy nfa2 transitions with offset
-        for (size_t i = 0; i < nfa2.states.size(); i++) {
-            for (const auto& trans : nfa2.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset, trans.first, to + offset);
-                }
-            }
-            for (int eps : nfa2.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset, eps + offset);
-            }
-        }
-        
-        // Connect nfa1 accepting to nfa2 start
-        for (int acc : nfa1.acceptStates) {
-            result.states[acc].isAccepting = false;
-            result.addEpsilonTransition(acc, nfa2.startState + offset);
-        }
-        
-        result.acceptStates.clear();
-        for (int acc : nfa2.acceptStates) {
-            result.setAccepting(acc + offset);
-        }
-        
-        return result;
+    Fragment emptyNFA(NFA& nfa) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        nfa.addEpsilonTransition(start, end);
+        return {start, end};
     }
     
-    NFA alternate(NFA nfa1, NFA nfa2) {
-        NFA result;
-        int start = result.addState();
-        result.startState = start;
-        
-        // Add nfa1 states
-        int offset1 = result.states.size();
-        for (const auto& state : nfa1.states) {
-            result.addState();
-        }
-        
-        // Copy nfa1 transitions
-        for (size_t i = 0; i < nfa1.states.size(); i++) {
-            for (const auto& trans : nfa1.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset1, trans.first, to + offset1);
-                }
-            }
-            for (int eps : nfa1.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset1, eps + offset1);
-            }
-        }
-        
-        // Add nfa2 states
-        int offset2 = result.states.size();
-        for (const auto& state : nfa2.states) {
-            result.addState();
-        }
-        
-        // Copy nfa2 transitions
-        for (size_t i = 0; i < nfa2.states.size(); i++) {
-            for (const auto& trans : nfa2.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset2, trans.first, to + offset2);
-                }
-            }
-            for (int eps : nfa2.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset2, eps + offset2);
-            }
-        }
-        
-        // Add end state
-        int end = result.addState();
-        
-        // Connect start to both NFAs
-        result.addEpsilonTransition(start, nfa1.startState + offset1);
-        result.addEpsilonTransition(start, nfa2.startState + offset2);
-        
-        // Connect both NFAs to end
-        for (int acc : nfa1.acceptStates) {
-            result.addEpsilonTransition(acc + offset1, end);
-        }
-        for (int acc : nfa2.acceptStates) {
-            result.addEpsilonTransition(acc + offset2, end);
-        }
-        
-        result.setAccepting(end);
-        return result;
+    Fragment concatenate(NFA& nfa, Fragment frag1, Fragment frag2) {
+        // Connect frag1 accepting to frag2 start
+        nfa.addEpsilonTransition(frag1.accept, frag2.start);
+        return {frag1.start, frag2.accept};
     }
     
-    NFA star(NFA nfa) {
-        NFA result;
-        int start = result.addState();
-        result.startState = start;
-        
-        // Add nfa states
-        int offset = result.states.size();
-        for (const auto& state : nfa.states) {
-            result.addState();
-        }
+    Fragment alternate(NFA& nfa, Fragment frag1, Fragment frag2) {
+        int start = nfa.addState();
+        int end = nfa.addState();
         
-        // Copy nfa transitions
-        for (size_t i = 0; i < nfa.states.size(); i++) {
-            for (const auto& trans : nfa.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset, trans.first, to + offset);
-                }
-            }
-            for (int eps : nfa.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset, eps + offset);
-            }
-        }
+        // Connect start to both fragments, and both fragments to end
+        nfa.addEpsilonTransition(start, frag1.start);
+        nfa.addEpsilonTransition(start, frag2.start);
+        nfa.addEpsilonTransition(frag1.accept, end);
+        nfa.addEpsilonTransition(frag2.accept, end);
         
-        int end = result.addState();
+        return {start, end};
+    }
+    
+    Fragment star(NFA& nfa, Fragment frag) {
+        int start = nfa.addState();
+        int end = nfa.addState();
         
-        // Connect start to nfa and end
-        result.addEpsilonTransition(start, nfa.startState + offset);
-        result.addEpsilonTransition(start, end);
+        // Connect start to fragment and end
+        nfa.addEpsilonTransition(start, frag.start);
+        nfa.addEpsilonTransition(start, end);
         
-        // Connect nfa accepting to end and back to start
-        for (int acc : nfa.acceptStates) {
-            result.addEpsilonTransition(acc + offset, end);
-            result.addEpsilonTransition(acc + offset, nfa.startState + offset);
-        }
+        // Connect fragment accepting to end and back to its start
+        nfa.addEpsilonTransition(frag.accept, end);
+        nfa.addEpsilonTransition(frag.accept, frag.start);
         
-        result.setAccepting(end);
-        return result;
+        return {start, end};
     }
     
-    // Parse and build NFA using Thompson's construction
+    // Parse and build NFA using Thompson's construction (shunting-yard over
+    // fragment handles; concatenation is an implicit '.' binding tighter
+    // than '|')
     NFA parseRegex(const string& regex) {
-        stack<NFA> nfaStack;
+        NFA nfa;
+        nfa.states.reserve(regex.length() * 2 + 2);
+        
+        stack<Fragment> fragStack;
         stack<char> opStack;
+        bool needConcat = false;
         
         for (size_t i = 0; i < regex.length(); i++) {
             char c = regex[i];
             
             if (isalnum(c)) {
-                nfaStack.push(charNFA(c));
+                if (needConcat) pushOperator('.', nfa, opStack, fragStack);
+                fragStack.push(charNFA(nfa, c));
+                needConcat = true;
             } else if (c == '(') {
+                if (needConcat) pushOperator('.', nfa, opStack, fragStack);
                 opStack.push(c);
+                needConcat = false;
             } else if (c == ')') {
                 while (!opStack.empty() && opStack.top() != '(') {
-                    processOperator(opStack.top(), nfaStack);
+                    processOperator(opStack.top(), nfa, fragStack);
                     opStack.pop();
                 }
                 if (!opStack.empty()) opStack.pop();  // Remove '('
+                needConcat = true;
             } else if (c == '|') {
-                while (!opStack.empty() && opStack.top() != '(') {
-                    processOperator(opStack.top(), nfaStack);
-                    opStack.pop();
-                }
-                opStack.push(c);
+                pushOperator('|', nfa, opStack, fragStack);
+                needConcat = false;
             } else if (c == '*') {
-                if (!nfaStack.empty()) {
-                    NFA nfa = nfaStack.top();
-                    nfaStack.pop();
-                    nfaStack.push(star(nfa));
+                if (!fragStack.empty()) {
+                    Fragment frag = fragStack.top();
+                    fragStack.pop();
+                    fragStack.push(star(nfa, frag));
                 }
             }
         }
         
         while (!opStack.empty()) {
-            processOperator(opStack.top(), nfaStack);
+            processOperator(opStack.top(), nfa, fragStack);
             opStack.pop();
         }
         
-        // Concatenate remaining NFAs
-        while (nfaStack.size() > 1) {
-            NFA nfa2 = nfaStack.top(); nfaStack.pop();
-            NFA nfa1 = nfaStack.top(); nfaStack.pop();
-            nfaStack.push(concatenate(nfa1, nfa2));
+        Fragment result = fragStack.empty() ? emptyNFA(nfa) : fragStack.top();
+        nfa.startState = result.start;
+        nfa.setAccepting(result.accept);
+        return nfa;
+    }
+    
+    // Get operator precedence
+    int precedence(char op) {
+        if (op == '|') return 1;
+        if (op == '.') return 2;
+        return 0;
+    }
+    
+    void pushOperator(char op, NFA& nfa, stack<char>& opStack, stack<Fragment>& fragStack) {
+        while (!opStack.empty() && opStack.top() != '(' &&
+               precedence(opStack.top()) >= precedence(op)) {
+            processOperator(opStack.top(), nfa, fragStack);
+            opStack.pop();
         }
-        
-        return nfaStack.top();
+        opStack.push(op);
     }
     
-    void processOperator(char op, stack<NFA>& nfaStack) {
-        if (op == '|' && nfaStack.size() >= 2) {
-            NFA nfa2 = nfaStack.top(); nfaStack.pop();
-            NFA nfa1 = nfaStack.top(); nfaStack.pop();
-            nfaStack.push(alternate(nfa1, nfa2));
+    void processOperator(char op, NFA& nfa, stack<Fragment>& fragStack) {
+        if (fragStack.size() < 2) return;
+        
+        Fragment frag2 = fragStack.top(); fragStack.pop();
+        Fragment frag1 = fragStack.top(); fragStack.pop();
+        if (op == '|') {
+            fragStack.push(alternate(nfa, frag1, frag2));
+        } else {
+            fragStack.push(concatenate(nfa, frag1, frag2));
         }
     }
     
@@ -1,402 +1,79 @@
-#include <iostream>
-#include <string>
-#include <vector>
-#include <set>
-#include <map>
-#include <stack>
-#include <queue>
-#include <algorithm>
-#include <iomanip>
+#include "regex_dfa.h"
 
 using namespace std;
 
-// NFA State
-struct NFAState {
-    int id;
-    map<char, set<int>> transitions;
-    set<int> epsilonTransitions;
-    bool isAccepting;
-    
-    NFAState(int id) : id(id), isAccepting(false) {}
-};
-
-// NFA
-class NFA {
-public:
-    vector<NFAState> states;
-    int startState;
-    set<int> acceptStates;
-    set<char> alphabet;
-    
-    NFA() : startState(0) {}
-    
-    int addState() {
-        int id = states.size();
-        states.push_back(NFAState(id));
-        return id;
-    }
-    
-    void addTransition(int from, char symbol, int to) {
-        states[from].transitions[symbol].insert(to);
-        if (symbol != '\0') alphabet.insert(symbol);
-    }
-    
-    void addEpsilonTransition(int from, int to) {
-        states[from].epsilonTransitions.insert(to);
-    }
-    
-    void setAccepting(int state) {
-        states[state].isAccepting = true;
-        acceptStates.insert(state);
-    }
-};
-
-// DFA
-class DFA {
-public:
-    map<set<int>, int> stateMap;
-    vector<set<int>> dfaStates;
-    map<int, map<char, int>> transitions;
-    int startState;
-    set<int> acceptStates;
-    set<char> alphabet;
-    
-    void print() {
-        cout << "\nDFA Transition Table:" << endl;
-        cout << string(50, '-') << endl;
-        
-        cout << setw(10) << "State" << " | ";
-        for (char c : alphabet) {
-            cout << setw(8) << c << " | ";
-        }
-        cout << setw(10) << "Accept" << endl;
-        cout << string(50, '-') << endl;
-        
-        for (size_t i = 0; i < dfaStates.size(); i++) {
-            if (i == startState) cout << "-> ";
-            else cout << "   ";
-            
-            cout << setw(7) << i << " | ";
-            
-            for (char c : alphabet) {
-                if (transitions[i].count(c)) {
-                    cout << setw(8) << transitions[i][c] << " | ";
-                } else {
-                    cout << setw(8) << "-" << " | ";
-                }
-            }
-            
-            if (acceptStates.count(i)) {
-                cout << setw(10) << "YES";
-            } else {
-                cout << setw(10) << "NO";
-            }
-            cout << endl;
-        }
-        cout << string(50, '-') << endl;
-    }
-    
-    bool validate(const string& str) {
-        int currentState = startState;
-        
-        for (char c : str) {
-            if (alphabet.find(c) == alphabet.end()) {
-                return false;
-            }
-            
-            if (transitions[currentState].count(c)) {
-                currentState = transitions[currentState][c];
-            } else {
-                return false;
-            }
-        }
-        
-        return acceptStates.count(currentState) > 0;
-    }
-};
-
-class RegexToDFA {
-private:
-    string regex;
-    
-    set<int> epsilonClosure(const set<int>& states, const NFA& nfa) {
-        set<int> closure = states;
-        queue<int> q;
-        
-        for (int s : states) q.push(s);
-        
-        while (!q.empty()) {
-            int state = q.front();
-            q.pop();
-            
-            for (int eps : nfa.states[state].epsilonTransitions) {
-                if (closure.find(eps) == closure.end()) {
-                    closure.insert(eps);
-                    q.push(eps);
-                }
-            }
-        }
-        
-        return closure;
-    }
-    
-    set<int> move(const set<int>& states, char symbol, const NFA& nfa) {
-        set<int> result;
-        
-        for (int s : states) {
-            if (nfa.states[s].transitions.count(symbol)) {
-                for (int next : nfa.states[s].transitions.at(symbol)) {
-                    result.insert(next);
-                }
-            }
+int main(int argc, char* argv[]) {
+    if ((argc == 4 || argc == 5) && string(argv[1]) == "--emit-cpp") {
+        RegexToDFA converter;
+        DFACodeGenerator::Style style = DFACodeGenerator::GOTO;
+        if (argc == 5 && string(argv[4]) == "table") style = DFACodeGenerator::TABLE;
+        DFACodeGenerator generator;
+        try {
+            DFA dfa = converter.convert(argv[2]).minimize();
+            cout << generator.generate(dfa, argv[3], style, argv[2]);
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
         }
-        
-        return result;
+        return 0;
     }
     
-    NFA charNFA(char c) {
-        NFA nfa;
-        int start = nfa.addState();
-        int end = nfa.addState();
-        nfa.addTransition(start, c, end);
-        nfa.startState = start;
-        nfa.setAccepting(end);
-        return nfa;
-    }
-    
-    NFA concatenate(NFA nfa1, NFA nfa2) {
-        NFA result = nfa1;
-        
-        int offset = result.states.size();
-        for (const auto& state : nfa2.states) {
-            result.addState();
-        }
-        
-        for (size_t i = 0; i < nfa2.states.size(); i++) {
-            for (const auto& trans : nfa2.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset, trans.first, to + offset);
-                }
-            }
-            for (int eps : nfa2.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset, eps + offset);
-            }
-        }
-        
-        for (int acc : nfa1.acceptStates) {
-            result.states[acc].isAccepting = false;
-            result.addEpsilonTransition(acc, nfa2.startState + offset);
-        }
-        
-        result.acceptStates.clear();
-        for (int acc : nfa2.acceptStates) {
-            result.setAccepting(acc + offset);
+    if (argc == 4 && string(argv[1]) == "--save-dfa") {
+        RegexToDFA converter;
+        try {
+            DFA dfa = converter.convert(argv[2]).minimize();
+            saveDFA(dfa, argv[3]);
+            cout << "Saved " << dfa.dfaStates.size() << "-state DFA to " << argv[3] << endl;
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
         }
-        
-        return result;
+        return 0;
     }
     
-    NFA alternate(NFA nfa1, NFA nfa2) {
-        NFA result;
-        int start = result.addState();
-        result.startState = start;
-        
-        int offset1 = result.states.size();
-        for (const auto& state : nfa1.states) {
-            result.addState();
-        }
-        
-        for (size_t i = 0; i < nfa1.states.size(); i++) {
-            for (const auto& trans : nfa1.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset1, trans.first, to + offset1);
-                }
-            }
-            for (int eps : nfa1.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset1, eps + offset1);
-            }
-        }
-        
-        int offset2 = result.states.size();
-        for (const auto& state : nfa2.states) {
-            result.addState();
-        }
-        
-        for (size_t i = 0; i < nfa2.states.size(); i++) {
-            for (const auto& trans : nfa2.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset2, trans.first, to + offset2);
-                }
-            }
-            for (int eps : nfa2.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset2, eps + offset2);
+    if (argc >= 3 && string(argv[1]) == "--load-dfa") {
+        try {
+            MappedDFA dfa(argv[2]);
+            for (int i = 3; i < argc; i++) {
+                cout << setw(10) << argv[i] << " : " << (dfa.validate(argv[i]) ? "ACCEPTED" : "REJECTED") << endl;
             }
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
         }
-        
-        int end = result.addState();
-        
-        result.addEpsilonTransition(start, nfa1.startState + offset1);
-        result.addEpsilonTransition(start, nfa2.startState + offset2);
-        
-        for (int acc : nfa1.acceptStates) {
-            result.addEpsilonTransition(acc + offset1, end);
-        }
-        for (int acc : nfa2.acceptStates) {
-            result.addEpsilonTransition(acc + offset2, end);
-        }
-        
-        result.setAccepting(end);
-        return result;
-    }
-    
-    NFA star(NFA nfa) {
-        NFA result;
-        int start = result.addState();
-        result.startState = start;
-        
-        int offset = result.states.size();
-        for (const auto& state : nfa.states) {
-            result.addState();
-        }
-        
-        for (size_t i = 0; i < nfa.states.size(); i++) {
-            for (const auto& trans : nfa.states[i].transitions) {
-                for (int to : trans.second) {
-                    result.addTransition(i + offset, trans.first, to + offset);
-                }
-            }
-            for (int eps : nfa.states[i].epsilonTransitions) {
-                result.addEpsilonTransition(i + offset, eps + offset);
-            }
-        }
-        
-        int end = result.addState();
-        
-        result.addEpsilonTransition(start, nfa.startState + offset);
-        result.addEpsilonTransition(start, end);
-        
-        for (int acc : nfa.acceptStates) {
-            result.addEpsilonTransition(acc + offset, end);
-            result.addEpsilonTransition(acc + offset, nfa.startState + offset);
-        }
-        
-        result.setAccepting(end);
-        return result;
+        return 0;
     }
     
-    NFA parseRegex(const string& regex) {
-        stack<NFA> nfaStack;
-        stack<char> opStack;
-        
-        for (size_t i = 0; i < regex.length(); i++) {
-            char c = regex[i];
-            
-            if (isalnum(c)) {
-                nfaStack.push(charNFA(c));
-            } else if (c == '(') {
-                opStack.push(c);
-            } else if (c == ')') {
-                while (!opStack.empty() && opStack.top() != '(') {
-                    processOperator(opStack.top(), nfaStack);
-                    opStack.pop();
-                }
-                if (!opStack.empty()) opStack.pop();
-            } else if (c == '|') {
-                while (!opStack.empty() && opStack.top() != '(') {
-                    processOperator(opStack.top(), nfaStack);
-                    opStack.pop();
-                }
-                opStack.push(c);
-            } else if (c == '*') {
-                if (!nfaStack.empty()) {
-                    NFA nfa = nfaStack.top();
-                    nfaStack.pop();
-                    nfaStack.push(star(nfa));
-                }
-            }
-        }
-        
-        while (!opStack.empty()) {
-            processOperator(opStack.top(), nfaStack);
-            opStack.pop();
+    if ((argc == 3 || argc == 4) && string(argv[1]) == "--stats") {
+        RegexToDFA converter;
+        try {
+            converter.convert(argv[2]);
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
         }
-        
-        while (nfaStack.size() > 1) {
-            NFA nfa2 = nfaStack.top(); nfaStack.pop();
-            NFA nfa1 = nfaStack.top(); nfaStack.pop();
-            nfaStack.push(concatenate(nfa1, nfa2));
+        if (argc == 4 && string(argv[3]) == "--json") {
+            cout << converter.stats().toJSON() << endl;
+        } else {
+            cout << "Compiling " << argv[2] << ":" << endl;
+            converter.stats().print();
         }
-        
-        return nfaStack.top();
+        return 0;
     }
     
-    void processOperator(char op, stack<NFA>& nfaStack) {
-        if (op == '|' && nfaStack.size() >= 2) {
-            NFA nfa2 = nfaStack.top(); nfaStack.pop();
-            NFA nfa1 = nfaStack.top(); nfaStack.pop();
-            nfaStack.push(alternate(nfa1, nfa2));
+    if (argc == 4 && string(argv[1]) == "--match-file") {
+        RegexToDFA converter;
+        try {
+            DFA dfa = converter.convert(argv[2]).minimize();
+            bool result = validateFile(dfa, argv[3]);
+            cout << argv[3] << " : " << (result ? "ACCEPTED" : "REJECTED") << endl;
+        } catch (const runtime_error& e) {
+            cerr << "Error: " << e.what() << endl;
+            return 1;
         }
+        return 0;
     }
     
-public:
-    DFA convert(const string& regex) {
-        this->regex = regex;
-        
-        NFA nfa = parseRegex(regex);
-        
-        DFA dfa;
-        dfa.alphabet = nfa.alphabet;
-        
-        set<int> startClosure = epsilonClosure({nfa.startState}, nfa);
-        
-        queue<set<int>> unmarked;
-        unmarked.push(startClosure);
-        dfa.stateMap[startClosure] = 0;
-        dfa.dfaStates.push_back(startClosure);
-        dfa.startState = 0;
-        
-        for (int s : startClosure) {
-            if (nfa.acceptStates.count(s)) {
-                dfa.acceptStates.insert(0);
-                break;
-            }
-        }
-        
-        while (!unmarked.empty()) {
-            set<int> current = unmarked.front();
-            unmarked.pop();
-            
-            int currentDFAState = dfa.stateMap[current];
-            
-            for (char symbol : nfa.alphabet) {
-                set<int> moveResult = move(current, symbol, nfa);
-                set<int> nextClosure = epsilonClosure(moveResult, nfa);
-                
-                if (!nextClosure.empty()) {
-                    if (dfa.stateMap.find(nextClosure) == dfa.stateMap.end()) {
-                        int newStateId = dfa.dfaStates.size();
-                        dfa.stateMap[nextClosure] = newStateId;
-                        dfa.dfaStates.push_back(nextClosure);
-                        unmarked.push(nextClosure);
-                        
-                        for (int s : nextClosure) {
-                            if (nfa.acceptStates.count(s)) {
-                                dfa.acceptStates.insert(newStateId);
-                                break;
-                            }
-                        }
-                    }
-                    
-                    dfa.transitions[currentDFAState][symbol] = dfa.stateMap[nextClosure];
-                }
-            }
-        }
-        
-        return dfa;
-    }
-};
-
-int main() {
     RegexToDFA converter;
     
     // Example: (0|1)*1(0|1)(0|1) - binary strings with 1 at third position from end
@@ -405,9 +82,13 @@ int main() {
     cout << "Regular Expression: " << regex << endl;
     cout << "Description: Binary strings with '1' at third position from the end" << endl;
     
-    DFA dfa = converter.convert(regex);
+    DFA raw = converter.convert(regex);
+    DFA dfa = raw.minimize();
     dfa.print();
     
+    cout << "\nDFA states: " << raw.dfaStates.size() << " after subset construction, "
+         << dfa.dfaStates.size() << " after minimization" << endl;
+    
     // Test strings
     vector<string> testStrings = {"1101", "111", "0001"};
     
@@ -429,5 +110,153 @@ int main() {
         cout << setw(10) << str << " : " << (result ? "ACCEPTED" : "REJECTED") << endl;
     }
     
+#if __cplusplus >= 202002L
+    // Compile-time DFA: built by the compiler, checked here by static_assert
+    static_assert(static_match<"(0|1)*1(0|1)(0|1)">("1101"));
+    static_assert(!static_match<"(0|1)*1(0|1)(0|1)">("0001"));
+    
+    cout << "\nCompile-time DFA (static_match):" << endl;
+    cout << string(30, '-') << endl;
+    for (const string& str : moreTests) {
+        bool result = static_match<"(0|1)*1(0|1)(0|1)">(str);
+        cout << setw(10) << str << " : " << (result ? "ACCEPTED" : "REJECTED") << endl;
+    }
+#endif
+    
+    // Streaming: the same input fed in chunks as it would arrive from a pipe
+    cout << "\nStreaming Validation (3-byte chunks):" << endl;
+    cout << string(30, '-') << endl;
+    DFAMatcher matcher(dfa);
+    for (const string& str : moreTests) {
+        matcher.reset();
+        for (size_t i = 0; i < str.size(); i += 3) {
+            matcher.feed(str.data() + i, min<size_t>(3, str.size() - i));
+        }
+        cout << setw(10) << str << " : " << (matcher.finish() ? "ACCEPTED" : "REJECTED") << endl;
+    }
+    
+    // Multi-pattern DFA: one pass reports every rule that matched
+    vector<string> rules = {"(a|b)*abb", "a(a|b)*b", "a*b*"};
+    DFA ruleDFA = converter.convert(rules).minimize();
+    
+    cout << "\nMulti-pattern Matching:" << endl;
+    cout << string(30, '-') << endl;
+    for (size_t i = 0; i < rules.size(); i++) {
+        cout << "  Rule " << i << ": " << rules[i] << endl;
+    }
+    vector<string> ruleTests = {"abb", "aabb", "ab", "ba", "bbb"};
+    for (const string& str : ruleTests) {
+        string ids;
+        for (int id : ruleDFA.matches(str)) ids += (ids.empty() ? "" : ", ") + to_string(id);
+        cout << setw(10) << str << " : " << (ids.empty() ? "no match" : "rules " + ids) << endl;
+    }
+    
+    // Character classes and bounded repetition compile to range transitions
+    // instead of spelled-out alternations and copies
+    string hexRegex = "[0-9a-f]{8}";
+    string spelledOut;
+    for (int i = 0; i < 8; i++) spelledOut += "(0|1|2|3|4|5|6|7|8|9|a|b|c|d|e|f)";
+    DFA hexDFA = converter.convert(hexRegex).minimize();
+    size_t nativeStates = converter.toNFA(hexRegex).states.size();
+    size_t spelledStates = converter.toNFA(spelledOut).states.size();
+    
+    cout << "\nCharacter class " << hexRegex << ": " << nativeStates << " NFA states ("
+         << spelledStates << " as an alternation), " << hexDFA.numClasses << " byte classes" << endl;
+    cout << string(30, '-') << endl;
+    for (const string& str : {string("deadbeef"), string("DEADBEEF"), string("0123456")}) {
+        cout << setw(10) << str << " : " << (hexDFA.validate(str) ? "ACCEPTED" : "REJECTED") << endl;
+    }
+    
+    // UTF-8: the Greek range is split into byte sequences (CE [B1-BF] |
+    // CF [80-89]), so the DFA reads raw bytes without decoding
+    string greekRegex = "[α-ω]+";
+    DFA greekDFA = converter.convert(greekRegex).minimize();
+    
+    cout << "\nUTF-8 pattern " << greekRegex << ": " << greekDFA.dfaStates.size() << " DFA states, "
+         << greekDFA.numClasses << " byte classes" << endl;
+    cout << string(30, '-') << endl;
+    for (const string& str : {string("λογος"), string("λόγος"), string("logos")}) {
+        cout << "  " << str << " : " << (greekDFA.validate(str) ? "ACCEPTED" : "REJECTED") << endl;
+    }
+    
+    // Unanchored search: the literal prefix "a" picks the candidate starts
+    string searchRegex = "a(a|b)*b";
+    DFA searchDFA = converter.convert(searchRegex).minimize();
+    string text = "ccabbcaabacbbab";
+    
+    cout << "\nSearch for " << searchRegex << " in \"" << text << "\":" << endl;
+    cout << string(30, '-') << endl;
+    for (DFA::Match match : searchDFA.findAll(text)) {
+        cout << "  [" << match.start << ", " << match.end << ") "
+             << text.substr(match.start, match.end - match.start) << endl;
+    }
+    
+    // No literal to skip to here, so the reverse DFA marks all match starts
+    // in one backward pass and the forward DFA extends each to its end
+    string spanRegex = "[ab]+c";
+    DFA spanDFA = converter.convertSearch(spanRegex).minimize();
+    string spanText = "cabcbbacxac";
+    
+    cout << "\nSearch for " << spanRegex << " in \"" << spanText << "\" (reverse DFA, "
+         << spanDFA.reverseDFA->dfaStates.size() << " states):" << endl;
+    cout << string(30, '-') << endl;
+    for (DFA::Match match : spanDFA.findAll(spanText)) {
+        cout << "  [" << match.start << ", " << match.end << ") "
+             << spanText.substr(match.start, match.end - match.start) << endl;
+    }
+    
+    // Lazy DFA: (0|1)*1(0|1){20} has 2^21 DFA states, too many to build eagerly
+    string lazyRegex = "(0|1)*1";
+    for (int i = 0; i < 20; i++) lazyRegex += "(0|1)";
+    LazyDFA lazy = converter.convertLazy(lazyRegex);
+    
+    cout << "\nLazy DFA for (0|1)*1(0|1){20}:" << endl;
+    cout << string(30, '-') << endl;
+    
+    string input;
+    unsigned seed = 12345;
+    for (int i = 0; i < 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        input += ((seed >> 16) & 1) ? '1' : '0';
+    }
+    for (char last : {'0', '1'}) {
+        string str = input;
+        str[str.size() - 21] = last;
+        bool result = lazy.validate(str);
+        cout << "  1 at 21st from end = " << (last == '1' ? "yes" : "no ") << " : "
+             << (result ? "ACCEPTED" : "REJECTED") << endl;
+    }
+    cout << "  Cached states: " << lazy.cachedStates() << " / " << lazy.cacheCapacity()
+         << ", flushes: " << lazy.flushes() << endl;
+    
+    // convertAuto() keeps the table DFA while it is small and otherwise
+    // picks by position count: 2n+2 positions here
+    cout << "\nAutomatic engine selection for (0|1)*1(0|1){n}:" << endl;
+    cout << string(30, '-') << endl;
+    for (int n : {4, 20, 40}) {
+        string autoRegex = "(0|1)*1";
+        for (int i = 0; i < n; i++) autoRegex += "(0|1)";
+        Matcher matcher = converter.convertAuto(autoRegex);
+        cout << "  n = " << setw(2) << n << ": " << setw(16) << left << matcher.engineName() << right
+             << " : " << (matcher.validate(input) ? "ACCEPTED" : "REJECTED") << endl;
+    }
+    
+    // With a budget, convert() refuses the 2^41-state DFA outright and
+    // convertAuto() falls back to simulating the NFA
+    cout << "\nDFA budget of 64 KiB for (0|1)*1(0|1){40}:" << endl;
+    cout << string(30, '-') << endl;
+    string budgetRegex = "(0|1)*1";
+    for (int i = 0; i < 40; i++) budgetRegex += "(0|1)";
+    RegexToDFA budgeted;
+    budgeted.budget.maxBytes = 64 << 10;
+    try {
+        budgeted.convert(budgetRegex);
+    } catch (const DFABudgetExceeded& e) {
+        cout << "  convert(): " << e.what() << endl;
+    }
+    Matcher fallback = budgeted.convertAuto(budgetRegex);
+    cout << "  convertAuto(): " << fallback.engineName() << " : "
+         << (fallback.validate(input) ? "ACCEPTED" : "REJECTED") << endl;
+    
     return 0;
 }
@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <regex>
 #include <algorithm>
+#include "regex_dfa.h"
 
 std::string trim(const std::string &s) {
     size_t start = s.find_first_not_of(" \t");
@@ -11,6 +12,30 @@ std::string trim(const std::string &s) {
     return (start == std::string::npos) ? "" : s.substr(start, end - start + 1);
 }
 
+enum TokenKind { IDENTIFIER, NUMBER, ASSIGN, OPERATOR };
+
+const Lexer lexer({
+    {IDENTIFIER, "[A-Za-z_][A-Za-z0-9_]*"},
+    {NUMBER, "[0-9]+"},
+    {ASSIGN, "\\="},
+    {OPERATOR, "[-+*/]"},
+    {Lexer::SKIP, "[ \t]+"},
+});
+
+// Splits a trimmed "lhs = rhs" line; false if it is not an assignment
+bool parseAssignment(const std::string &line, std::vector<Token> &tokens,
+                     std::string &lhs, std::string &rhs) {
+    tokens.clear();
+    lexer.tokenize(line, tokens);
+    if (tokens.size() < 3 || tokens[0].kind != IDENTIFIER || tokens[0].offset != 0 ||
+        tokens[1].kind != ASSIGN) {
+        return false;
+    }
+    lhs = line.substr(0, tokens[0].length);
+    rhs = line.substr(tokens[2].offset);
+    return true;
+}
+
 int main() {
     std::vector<std::string> code = {
         "x = 2 * 8",
@@ -20,24 +45,30 @@ int main() {
     
     std::unordered_map<std::string, std::string> values;
     std::vector<std::string> optimized;
+    std::vector<Token> tokens;
     
     // Step 1: Constant folding and strength reduction
     for (auto &line : code) {
         line = trim(line);
         if (line.empty()) continue;
         
-        std::regex assign_re(R"((\w+)\s*=\s*(.+))");
-        std::smatch match;
+        std::string lhs, rhs;
         
-        if (std::regex_match(line, match, assign_re)) {
-            std::string lhs = match[1];
-            std::string rhs = trim(match[2]);
-            
+        if (parseAssignment(line, tokens, lhs, rhs)) {
             // Replace variables with their known values
-            for (auto &pair : values) {
-                std::regex var_pattern("\\b" + pair.first + "\\b");
-                rhs = std::regex_replace(rhs, var_pattern, pair.second);
+            std::string expr = rhs;
+            rhs.clear();
+            size_t copied = 0;
+            tokens.clear();
+            lexer.tokenize(expr, tokens);
+            for (const Token &token : tokens) {
+                if (token.kind != IDENTIFIER) continue;
+                auto known = values.find(expr.substr(token.offset, token.length));
+                if (known == values.end()) continue;
+                rhs += expr.substr(copied, token.offset - copied) + known->second;
+                copied = token.offset + token.length;
             }
+            rhs += expr.substr(copied);
             
             rhs = trim(rhs);
             
@@ -90,30 +121,25 @@ int main() {
     
     // Mark the last variable as used
     if (!optimized.empty()) {
-        std::regex assign_re(R"((\w+)\s*=\s*(.+))");
-        std::smatch match;
-        if (std::regex_match(optimized.back(), match, assign_re)) {
-            used[match[1]] = true;
+        std::string lhs, rhs;
+        if (parseAssignment(optimized.back(), tokens, lhs, rhs)) {
+            used[lhs] = true;
         }
     }
     
     // Backwards pass to find all used variables
     for (int i = (int)optimized.size() - 1; i >= 0; --i) {
-        std::regex assign_re(R"((\w+)\s*=\s*(.+))");
-        std::smatch match;
+        std::string lhs, rhs;
         
-        if (std::regex_match(optimized[i], match, assign_re)) {
-            std::string lhs = match[1];
-            std::string rhs = match[2];
-            
+        if (parseAssignment(optimized[i], tokens, lhs, rhs)) {
             if (used[lhs]) {
                 finalCode.push_back(optimized[i]);
                 
                 // Mark variables in RHS as used
-                std::regex var_re(R"(\b[a-zA-Z_]\w*\b)");
-                for (auto it = std::sregex_iterator(rhs.begin(), rhs.end(), var_re);
-                     it != std::sregex_iterator(); ++it) {
-                    used[it->str()] = true;
+                tokens.clear();
+                lexer.tokenize(rhs, tokens);
+                for (const Token &token : tokens) {
+                    if (token.kind == IDENTIFIER) used[rhs.substr(token.offset, token.length)] = true;
                 }
             }
         }
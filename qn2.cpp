@@ -4,6 +4,7 @@
 #include <stack>
 #include <cctype>
 #include <sstream>
+#include "regex_dfa.h"
 
 using namespace std;
 
@@ -11,28 +12,26 @@ class StackCodeGenerator {
 private:
     vector<string> code;
     
+    enum TokenKind { OPERAND, SYMBOL };
+    
+    // Operands are identifiers or numbers; anything else unmatched is
+    // dropped, as before
+    Lexer lexer{{
+        {OPERAND, "[A-Za-z0-9_]+"},
+        {SYMBOL, "[-+*/()]"},
+        {Lexer::SKIP, "[ \t\r\n]+"},
+    }};
+    vector<Token> lexed;
+    
     // Tokenize the expression
     vector<string> tokenize(const string& expr) {
         vector<string> tokens;
-        string token;
+        lexed.clear();
+        lexer.tokenize(expr, lexed);
         
-        for (size_t i = 0; i < expr.length(); i++) {
-            char c = expr[i];
-            
-            if (isspace(c)) {
-                continue;
-            } else if (isalnum(c) || c == '_') {
-                token += c;
-                // Check if next char is also part of identifier
-                if (i + 1 >= expr.length() || 
-                    (!isalnum(expr[i+1]) && expr[i+1] != '_')) {
-                    tokens.push_back(token);
-                    token.clear();
-                }
-            } else if (c == '+' || c == '-' || c == '*' || c == '/' || 
-                       c == '(' || c == ')') {
-                tokens.push_back(string(1, c));
-            }
+        for (const Token& token : lexed) {
+            if (token.kind == Lexer::UNMATCHED) continue;
+            tokens.push_back(expr.substr(token.offset, token.length));
         }
         
         return tokens;
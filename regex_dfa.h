@@ -0,0 +1,3385 @@
+#ifndef REGEX_DFA_H
+#define REGEX_DFA_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <array>
+#include <unordered_map>
+#include <stack>
+#include <queue>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+#include <string_view>
+#include <chrono>
+#include <stdexcept>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if __cplusplus >= 202002L
+#include <span>
+#endif
+
+// Symbol transition taken on any byte in [lo, hi]
+struct Transition {
+    unsigned char lo;
+    unsigned char hi;
+    int to;
+    
+    bool covers(unsigned char c) const { return lo <= c && c <= hi; }
+};
+
+// NFA State
+struct NFAState {
+    int id;
+    std::vector<Transition> transitions;
+    std::set<int> epsilonTransitions;
+    bool isAccepting;
+    int matchId;  // pattern id reported when this state accepts
+    
+    NFAState(int id) : id(id), isAccepting(false), matchId(0) {}
+};
+
+// NFA
+class NFA {
+public:
+    std::vector<NFAState> states;
+    int startState;
+    std::set<int> acceptStates;
+    std::set<char> alphabet;
+    
+    NFA() : startState(0) {}
+    
+    int addState() {
+        int id = states.size();
+        states.push_back(NFAState(id));
+        return id;
+    }
+    
+    void addTransition(int from, char symbol, int to) {
+        addRangeTransition(from, symbol, symbol, to);
+    }
+    
+    void addRangeTransition(int from, unsigned char lo, unsigned char hi, int to) {
+        states[from].transitions.push_back({lo, hi, to});
+        for (int c = lo; c <= hi; c++) {
+            if (c != '\0') alphabet.insert((char)c);
+        }
+    }
+    
+    void addEpsilonTransition(int from, int to) {
+        states[from].epsilonTransitions.insert(to);
+    }
+    
+    void setAccepting(int state, int matchId = 0) {
+        states[state].isAccepting = true;
+        states[state].matchId = matchId;
+        acceptStates.insert(state);
+    }
+    
+    // The same language read right to left: every edge flipped, and a new
+    // start state with epsilon edges to the old accept states. With
+    // unanchored set, the new start also loops on every byte, so a match
+    // of the reversed NFA may begin anywhere.
+    NFA reversed(bool unanchored) const {
+        NFA result;
+        for (size_t i = 0; i < states.size(); i++) result.addState();
+        for (const NFAState& state : states) {
+            for (const Transition& t : state.transitions) {
+                result.addRangeTransition(t.to, t.lo, t.hi, state.id);
+            }
+            for (int to : state.epsilonTransitions) result.addEpsilonTransition(to, state.id);
+        }
+        result.startState = result.addState();
+        for (int s : acceptStates) result.addEpsilonTransition(result.startState, s);
+        if (unanchored) result.addRangeTransition(result.startState, 0, 255, result.startState);
+        result.setAccepting(startState);
+        return result;
+    }
+};
+
+// Sub-automaton inside an NFA arena, referenced by its entry and exit states
+struct Fragment {
+    int start;
+    int accept;
+};
+
+// Dense bitset over NFA state ids. Used for subset construction state sets
+// and interned as a whole through StateSetHash.
+struct StateSet {
+    std::vector<uint64_t> words;
+    
+    StateSet() {}
+    explicit StateSet(size_t numStates) : words((numStates + 63) / 64, 0) {}
+    
+    void insert(int s) { words[s >> 6] |= uint64_t(1) << (s & 63); }
+    bool contains(int s) const { return (words[s >> 6] >> (s & 63)) & 1; }
+    
+    bool empty() const {
+        for (uint64_t w : words) {
+            if (w) return false;
+        }
+        return true;
+    }
+    
+    bool intersects(const StateSet& other) const {
+        size_t n = std::min(words.size(), other.words.size());
+        for (size_t i = 0; i < n; i++) {
+            if (words[i] & other.words[i]) return true;
+        }
+        return false;
+    }
+    
+    void unionWith(const StateSet& other) {
+        if (words.size() < other.words.size()) words.resize(other.words.size(), 0);
+        for (size_t i = 0; i < other.words.size(); i++) words[i] |= other.words[i];
+    }
+    
+    template <typename F>
+    void forEach(F f) const {
+        for (size_t i = 0; i < words.size(); i++) {
+            uint64_t w = words[i];
+            while (w) {
+                f((int)(i * 64 + __builtin_ctzll(w)));
+                w &= w - 1;
+            }
+        }
+    }
+    
+    bool operator==(const StateSet& other) const { return words == other.words; }
+};
+
+struct StateSetHash {
+    size_t operator()(const StateSet& set) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (uint64_t w : set.words) {
+            h ^= w;
+            h *= 0x100000001b3ULL;
+            h ^= h >> 29;
+        }
+        return h;
+    }
+};
+
+// Fixed set of worker threads. parallelFor() gives every participant its own
+// contiguous range of indices; a participant that runs dry steals the upper
+// half of another's remaining range, so uneven tasks balance themselves.
+// The calling thread takes part as participant 0.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) : stopping(false) {
+        threads = std::max(threads, 1u);
+        for (unsigned i = 1; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+    
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+    
+    size_t size() const { return workers.size() + 1; }
+    
+    // Runs body(i) for every i in [0, count) and returns when all are done.
+    // Must not be called from inside a pool task.
+    void parallelFor(size_t count, const std::function<void(size_t)>& body) {
+        // StealRange packs 32-bit bounds, so larger counts run in blocks
+        for (size_t base = 0; base < count; base += UINT32_MAX) {
+            parallelForBlock(base, std::min<size_t>(count - base, UINT32_MAX), body);
+        }
+    }
+    
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex queueMutex;
+    std::condition_variable wakeup;
+    std::condition_variable finished;
+    bool stopping;
+    
+    // body(base + i) for every i in [0, count), count < 2^32
+    void parallelForBlock(size_t base, size_t count, const std::function<void(size_t)>& body) {
+        size_t participants = std::min(count, size());
+        std::vector<StealRange> ranges(participants);
+        for (size_t p = 0; p < participants; p++) {
+            ranges[p].store(count * p / participants, count * (p + 1) / participants);
+        }
+        
+        auto drain = [&](size_t self) {
+            while (true) {
+                uint32_t i;
+                while (ranges[self].popFront(i)) body(base + i);
+                
+                bool stole = false;
+                for (size_t v = 1; v < participants && !stole; v++) {
+                    stole = ranges[(self + v) % participants].stealHalf(ranges[self]);
+                }
+                if (!stole) return;
+            }
+        };
+        
+        size_t helpers = participants - 1;
+        size_t helpersDone = 0;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (size_t p = 1; p <= helpers; p++) {
+                tasks.push([&, p] {
+                    drain(p);
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    if (++helpersDone == helpers) finished.notify_all();
+                });
+            }
+        }
+        wakeup.notify_all();
+        
+        drain(0);
+        
+        std::unique_lock<std::mutex> lock(queueMutex);
+        finished.wait(lock, [&] { return helpersDone == helpers; });
+    }
+    
+    // Index range [begin, end) packed into one atomic word. The owner pops
+    // from the front; thieves split off the upper half with a CAS.
+    struct alignas(64) StealRange {
+        std::atomic<uint64_t> bounds{0};
+        
+        void store(uint64_t begin, uint64_t end) { bounds.store(begin << 32 | end); }
+        
+        bool popFront(uint32_t& index) {
+            uint64_t b = bounds.load();
+            while (true) {
+                uint32_t begin = b >> 32, end = (uint32_t)b;
+                if (begin >= end) return false;
+                if (bounds.compare_exchange_weak(b, (uint64_t)(begin + 1) << 32 | end)) {
+                    index = begin;
+                    return true;
+                }
+            }
+        }
+        
+        bool stealHalf(StealRange& thief) {
+            uint64_t b = bounds.load();
+            while (true) {
+                uint32_t begin = b >> 32, end = (uint32_t)b;
+                if (begin >= end) return false;
+                uint32_t mid = begin + (end - begin) / 2;
+                if (bounds.compare_exchange_weak(b, (uint64_t)begin << 32 | mid)) {
+                    thief.store(mid, end);
+                    return true;
+                }
+            }
+        }
+    };
+    
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                wakeup.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+};
+
+// Epsilon closure of every NFA state, computed once with an iterative Tarjan
+// SCC pass. SCCs come out in reverse topological order, so each closure is
+// its members plus the already finished closures of its successor SCCs.
+class EpsilonClosures {
+public:
+    std::vector<int> sccOf;
+    std::vector<StateSet> sccClosure;
+    
+    EpsilonClosures() {}
+    
+    explicit EpsilonClosures(const NFA& nfa) {
+        int n = nfa.states.size();
+        std::vector<std::vector<int>> adj(n);
+        for (int v = 0; v < n; v++) {
+            adj[v].assign(nfa.states[v].epsilonTransitions.begin(), nfa.states[v].epsilonTransitions.end());
+        }
+        
+        std::vector<int> index(n, -1), low(n, 0);
+        std::vector<char> onStack(n, 0);
+        std::vector<int> sccStack;
+        std::vector<std::pair<int, size_t>> callStack;
+        int counter = 0;
+        sccOf.assign(n, -1);
+        
+        for (int root = 0; root < n; root++) {
+            if (index[root] != -1) continue;
+            index[root] = low[root] = counter++;
+            sccStack.push_back(root);
+            onStack[root] = 1;
+            callStack.push_back({root, 0});
+            
+            while (!callStack.empty()) {
+                int v = callStack.back().first;
+                size_t i = callStack.back().second;
+                
+                if (i < adj[v].size()) {
+                    callStack.back().second++;
+                    int w = adj[v][i];
+                    if (index[w] == -1) {
+                        index[w] = low[w] = counter++;
+                        sccStack.push_back(w);
+                        onStack[w] = 1;
+                        callStack.push_back({w, 0});
+                    } else if (onStack[w]) {
+                        low[v] = std::min(low[v], index[w]);
+                    }
+                    continue;
+                }
+                
+                if (low[v] == index[v]) {
+                    int c = sccClosure.size();
+                    std::vector<int> members;
+                    int m;
+                    do {
+                        m = sccStack.back();
+                        sccStack.pop_back();
+                        onStack[m] = 0;
+                        sccOf[m] = c;
+                        members.push_back(m);
+                    } while (m != v);
+                    
+                    StateSet closure(n);
+                    for (int member : members) closure.insert(member);
+                    for (int member : members) {
+                        for (int w : adj[member]) {
+                            if (sccOf[w] != c) closure.unionWith(sccClosure[sccOf[w]]);
+                        }
+                    }
+                    sccClosure.push_back(std::move(closure));
+                }
+                
+                callStack.pop_back();
+                if (!callStack.empty()) {
+                    int parent = callStack.back().first;
+                    low[parent] = std::min(low[parent], low[v]);
+                }
+            }
+        }
+    }
+    
+    const StateSet& of(int state) const { return sccClosure[sccOf[state]]; }
+    
+    // Closure of move(states, symbol) as a union of precomputed closures. A
+    // target already in the result is skipped: its closure is contained in
+    // the closure that added it.
+    StateSet step(const StateSet& states, char symbol, const NFA& nfa) const {
+        StateSet result(nfa.states.size());
+        
+        states.forEach([&](int s) {
+            for (const Transition& trans : nfa.states[s].transitions) {
+                if (trans.covers(symbol) && !result.contains(trans.to)) result.unionWith(of(trans.to));
+            }
+        });
+        
+        return result;
+    }
+};
+
+// Partition of the 256 byte values into classes that no NFA transition
+// tells apart. Each byte's signature lists the (state, target) pairs it
+// has a transition for, so the ranges of one character class share a
+// class. DFA tables get one column per class instead of one per byte.
+struct ByteClasses {
+    std::array<uint8_t, 256> classOf{};
+    std::vector<unsigned char> representative;  // some byte of each class
+    
+    ByteClasses() : representative(1, 0) {}
+    
+    explicit ByteClasses(const NFA& nfa) {
+        std::vector<std::vector<int>> signature(256);
+        int edges = 0;
+        std::map<int, int> edgeOf;
+        for (const NFAState& state : nfa.states) {
+            edgeOf.clear();
+            for (const Transition& trans : state.transitions) {
+                int edge = edgeOf.emplace(trans.to, edges).first->second;
+                if (edge == edges) edges++;
+                for (int c = trans.lo; c <= trans.hi; c++) {
+                    if (signature[c].empty() || signature[c].back() != edge) signature[c].push_back(edge);
+                }
+            }
+        }
+        
+        std::map<std::vector<int>, int> classIds;
+        for (int c = 0; c < 256; c++) {
+            auto inserted = classIds.emplace(signature[c], (int)representative.size());
+            if (inserted.second) representative.push_back(c);
+            classOf[c] = inserted.first->second;
+        }
+    }
+    
+    int count() const { return representative.size(); }
+};
+
+// Literal facts about a regex, derived from its syntax tree: every match
+// starts with prefix, ends with suffix and contains required. exact means
+// the regex matches the one string prefix and nothing else.
+struct Literals {
+    static constexpr size_t MAX_LENGTH = 64;
+    static constexpr size_t UNBOUNDED = SIZE_MAX;
+    
+    std::string prefix;
+    std::string suffix;
+    std::string required;
+    bool exact = false;
+    size_t maxLength = 0;  // longest match, or UNBOUNDED
+};
+
+// Skip loop for unanchored search. Positions where no match can start are
+// passed over with memchr/memmem instead of being run through the DFA.
+struct Prefilter {
+    std::string prefix;
+    std::string required;
+    size_t maxLength = Literals::UNBOUNDED;
+    
+    Prefilter() = default;
+    
+    explicit Prefilter(const Literals& literals)
+        : prefix(literals.prefix), maxLength(literals.maxLength) {
+        // A factor bounds where a match can start only if matches have a
+        // maximum length, and adds nothing if it is no longer than the prefix
+        if (maxLength != Literals::UNBOUNDED && literals.required.size() > prefix.size()) {
+            required = literals.required;
+        }
+    }
+    
+    bool empty() const { return prefix.empty() && required.empty(); }
+    
+    // First position >= from at which a match could start, or npos.
+    // factorAt caches an occurrence of required between calls.
+    size_t next(std::string_view text, size_t from, size_t& factorAt) const {
+        if (from > text.size()) return std::string_view::npos;
+        if (!required.empty()) {
+            if (factorAt < from) factorAt = locate(text, required, from);
+            if (factorAt == std::string_view::npos) return factorAt;
+            // A match starting at from contains an occurrence at or after
+            // this one and is at most maxLength long
+            if (factorAt + required.size() > from + maxLength) {
+                from = factorAt + required.size() - maxLength;
+            }
+        }
+        if (!prefix.empty()) return locate(text, prefix, from);
+        return from;
+    }
+    
+    static size_t locate(std::string_view text, const std::string& literal, size_t from) {
+        const char* data = text.data() + from;
+        size_t length = text.size() - from;
+        const void* found = literal.size() == 1
+            ? memchr(data, literal[0], length)
+            : memmem(data, length, literal.data(), literal.size());
+        return found ? (const char*)found - text.data() : std::string_view::npos;
+    }
+};
+
+// Packed bits, one per input, as returned by DFA::validateBatch()
+struct BitVector {
+    std::vector<uint64_t> words;
+    size_t count = 0;
+    
+    BitVector() {}
+    explicit BitVector(size_t count) : words((count + 63) / 64, 0), count(count) {}
+    
+    size_t size() const { return count; }
+    bool operator[](size_t i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    
+    size_t popcount() const {
+        size_t total = 0;
+        for (uint64_t w : words) total += __builtin_popcountll(w);
+        return total;
+    }
+};
+
+// DFA
+class DFA {
+public:
+    static constexpr int32_t DEAD_STATE = -1;
+    
+    std::unordered_map<StateSet, int, StateSetHash> stateMap;
+    std::vector<StateSet> dfaStates;
+    int startState;
+    std::set<int> acceptStates;
+    std::set<char> alphabet;
+    int numPatterns = 1;
+    std::vector<std::vector<int>> acceptIds;  // sorted pattern ids accepted per state
+    Prefilter prefilter;            // literals every match contains, used by find()
+    
+    // Minimized DFA of the reversed regex behind a loop on every byte, set
+    // by RegexToDFA::convertSearch(). Run right to left from the end of a
+    // text, it accepts exactly at the positions where a match starts.
+    std::shared_ptr<const DFA> reverseDFA;
+    
+    // table[(state << classShift) + classMap[byte]] holds the next state, or
+    // DEAD_STATE if the byte has no transition. Rows are padded to a power
+    // of two so the index is a shift rather than a multiply. freeze() builds
+    // the rest; the ids accepted in state s are
+    // matchIdList[matchIdStart[s]..matchIdStart[s+1]).
+    int numClasses = 1;
+    int classShift = 0;
+    std::array<uint8_t, 256> classMap{};
+    std::vector<int32_t> table;
+    std::vector<uint8_t> accepting;
+    std::vector<int32_t> matchIdStart;
+    std::vector<int32_t> matchIdList;
+    
+    // Non-owning view of the pattern ids accepted in one state
+    struct IdRange {
+        const int32_t* first;
+        const int32_t* last;
+        
+        const int32_t* begin() const { return first; }
+        const int32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+    
+    void setClasses(const std::array<uint8_t, 256>& classOf, int count) {
+        classMap = classOf;
+        numClasses = count;
+        classShift = 0;
+        while ((1 << classShift) < numClasses) classShift++;
+    }
+    
+    size_t rowStride() const { return (size_t)1 << classShift; }
+    
+    // Appends a row for a new state with every transition dead
+    void addRow() { table.resize(table.size() + rowStride(), DEAD_STATE); }
+    
+    int32_t& next(int32_t state, int cls) { return table[((size_t)state << classShift) + cls]; }
+    int32_t next(int32_t state, int cls) const { return table[((size_t)state << classShift) + cls]; }
+    
+    void freeze() {
+        size_t numStates = dfaStates.size();
+        table.resize(numStates * rowStride(), DEAD_STATE);
+        accepting.assign(numStates, 0);
+        acceptIds.resize(numStates);
+        
+        for (int s : acceptStates) {
+            accepting[s] = 1;
+        }
+        
+        matchIdStart.assign(1, 0);
+        matchIdList.clear();
+        for (size_t s = 0; s < numStates; s++) {
+            matchIdList.insert(matchIdList.end(), acceptIds[s].begin(), acceptIds[s].end());
+            matchIdStart.push_back(matchIdList.size());
+        }
+    }
+    
+    void print() const {
+        std::cout << "\nDFA Transition Table:" << std::endl;
+        std::cout << std::string(50, '-') << std::endl;
+        
+        std::cout << std::setw(10) << "State" << " | ";
+        for (char c : alphabet) {
+            std::cout << std::setw(8) << c << " | ";
+        }
+        std::cout << std::setw(10) << "Accept" << std::endl;
+        std::cout << std::string(50, '-') << std::endl;
+        
+        for (size_t i = 0; i < dfaStates.size(); i++) {
+            if ((int)i == startState) std::cout << "-> ";
+            else std::cout << "   ";
+            
+            std::cout << std::setw(7) << i << " | ";
+            
+            for (char c : alphabet) {
+                int32_t target = next(i, classMap[(unsigned char)c]);
+                if (target != DEAD_STATE) {
+                    std::cout << std::setw(8) << target << " | ";
+                } else {
+                    std::cout << std::setw(8) << "-" << " | ";
+                }
+            }
+            
+            if (acceptStates.count(i) && numPatterns > 1) {
+                std::string ids;
+                for (int id : acceptIds[i]) ids += (ids.empty() ? "" : ",") + std::to_string(id);
+                std::cout << std::setw(10) << "{" + ids + "}";
+            } else if (acceptStates.count(i)) {
+                std::cout << std::setw(10) << "YES";
+            } else {
+                std::cout << std::setw(10) << "NO";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << std::string(50, '-') << std::endl;
+    }
+    
+    // One dependent table load per byte (the class lookup does not depend
+    // on the state); bytes outside the alphabet hit DEAD_STATE.
+    int32_t run(int32_t currentState, const char* data, size_t length) const {
+        const int32_t* next = table.data();
+        const uint8_t* classOf = classMap.data();
+        const unsigned char* bytes = (const unsigned char*)data;
+        int shift = classShift;
+        
+        for (size_t i = 0; i < length; i++) {
+            currentState = next[((size_t)currentState << shift) + classOf[bytes[i]]];
+            if (currentState == DEAD_STATE) {
+                return DEAD_STATE;
+            }
+        }
+        
+        return currentState;
+    }
+    
+    int32_t finalState(std::string_view str) const {
+        return run(startState, str.data(), str.size());
+    }
+    
+    bool validate(std::string_view str) const {
+        int32_t state = finalState(str);
+        return state != DEAD_STATE && accepting[state] != 0;
+    }
+    
+    // Validates many independent inputs, stepping BATCH_LANES of them in
+    // lockstep so their table loads overlap instead of forming one serial
+    // chain. A dead lane keeps loading row 0 and ORs in the sign of
+    // DEAD_STATE, which keeps the inner loop branch-free. Lanes are
+    // refilled from the remaining inputs as soon as they finish, so skewed
+    // lengths do not leave lanes idle.
+    static constexpr int BATCH_LANES = 8;
+    
+    void validate(const std::string_view* inputs, size_t count, bool* results) const {
+        const int32_t* next = table.data();
+        const uint8_t* classOf = classMap.data();
+        int shift = classShift;
+        const unsigned char* pos[BATCH_LANES];
+        size_t remaining[BATCH_LANES];
+        int32_t state[BATCH_LANES];
+        size_t index[BATCH_LANES];
+        int active = 0;
+        size_t nextInput = 0;
+        
+        auto refill = [&](int lane) {
+            while (nextInput < count) {
+                size_t i = nextInput++;
+                if (inputs[i].empty()) {
+                    results[i] = accepting[startState] != 0;
+                    continue;
+                }
+                pos[lane] = (const unsigned char*)inputs[i].data();
+                remaining[lane] = inputs[i].size();
+                state[lane] = startState;
+                index[lane] = i;
+                return true;
+            }
+            return false;
+        };
+        
+        while (active < BATCH_LANES && refill(active)) active++;
+        
+        while (active > 0) {
+            size_t steps = 64;
+            for (int l = 0; l < active; l++) steps = std::min(steps, remaining[l]);
+            
+            for (size_t i = 0; i < steps; i++) {
+                for (int l = 0; l < active; l++) {
+                    int32_t s = state[l];
+                    int32_t row = s & ~(s >> 31);
+                    state[l] = next[((size_t)row << shift) + classOf[pos[l][i]]] | (s >> 31);
+                }
+            }
+            
+            for (int l = 0; l < active; l++) {
+                pos[l] += steps;
+                remaining[l] -= steps;
+                if (remaining[l] != 0 && state[l] != DEAD_STATE) continue;
+                
+                results[index[l]] = state[l] != DEAD_STATE && accepting[state[l]] != 0;
+                if (!refill(l)) {
+                    active--;
+                    pos[l] = pos[active];
+                    remaining[l] = remaining[active];
+                    state[l] = state[active];
+                    index[l] = index[active];
+                    l--;
+                }
+            }
+        }
+    }
+    
+    // Data-parallel matching of one large input. Chunk 0 runs from the start
+    // state; every other chunk runs from all states at once and records where
+    // each one ends up, and composing those maps gives the exact final state.
+    // Lanes that reach the same state are merged, so for small DFAs the
+    // extra work vanishes after a few bytes.
+    static constexpr size_t PARALLEL_MIN_CHUNK = 1 << 20;
+    
+    int32_t finalStateParallel(std::string_view str, ThreadPool& pool) const {
+        size_t chunks = std::min(pool.size(), str.size() / PARALLEL_MIN_CHUNK);
+        if (chunks <= 1) return finalState(str);
+        
+        size_t chunkSize = str.size() / chunks;
+        std::vector<std::vector<int32_t>> chunkMaps(chunks);
+        int32_t firstEnd = DEAD_STATE;
+        
+        pool.parallelFor(chunks, [&](size_t c) {
+            size_t begin = c * chunkSize;
+            size_t length = (c + 1 == chunks) ? str.size() - begin : chunkSize;
+            if (c == 0) {
+                firstEnd = run(startState, str.data(), length);
+            } else {
+                chunkMaps[c] = stateMapping(str.data() + begin, length);
+            }
+        });
+        
+        int32_t state = firstEnd;
+        for (size_t c = 1; c < chunks && state != DEAD_STATE; c++) {
+            state = chunkMaps[c][state];
+        }
+        return state;
+    }
+    
+    bool validateParallel(std::string_view str, ThreadPool& pool) const {
+        int32_t state = finalStateParallel(str, pool);
+        return state != DEAD_STATE && accepting[state] != 0;
+    }
+    
+    // Validates a large batch of independent inputs across the pool. The
+    // batch is cut into chunks of about equal cost (bytes plus a fixed
+    // per-input charge), so a few long strings do not leave one thread
+    // with all the work, and the pool steals chunks to even out the rest.
+    // Chunks start on multiples of 64 inputs, so each result word has a
+    // single writer. Within a chunk, groups of BATCH_GROUP inputs go
+    // through the interleaved validate() via a stack buffer.
+    static constexpr size_t BATCH_GROUP = 4096;
+    static constexpr size_t BATCH_INPUT_COST = 16;
+    static constexpr size_t BATCH_CHUNKS_PER_THREAD = 8;
+    
+    BitVector validateBatch(const std::string_view* inputs, size_t count, ThreadPool& pool) const {
+        BitVector results(count);
+        if (count == 0) return results;
+        
+        size_t blocks = (count + 63) / 64;
+        size_t totalCost = 0;
+        for (size_t i = 0; i < count; i++) totalCost += inputs[i].size() + BATCH_INPUT_COST;
+        size_t chunkCost = totalCost / std::min(blocks, pool.size() * BATCH_CHUNKS_PER_THREAD) + 1;
+        
+        std::vector<size_t> chunkStart = {0};  // in blocks of 64 inputs
+        size_t cost = 0;
+        for (size_t b = 0; b + 1 < blocks; b++) {
+            for (size_t i = b * 64; i < (b + 1) * 64; i++) cost += inputs[i].size() + BATCH_INPUT_COST;
+            if (cost >= chunkCost) {
+                chunkStart.push_back(b + 1);
+                cost = 0;
+            }
+        }
+        chunkStart.push_back(blocks);
+        
+        pool.parallelFor(chunkStart.size() - 1, [&](size_t c) {
+            bool matched[BATCH_GROUP];
+            size_t end = std::min(count, chunkStart[c + 1] * 64);
+            for (size_t begin = chunkStart[c] * 64; begin < end; begin += BATCH_GROUP) {
+                size_t n = std::min(BATCH_GROUP, end - begin);
+                validate(inputs + begin, n, matched);
+                for (size_t j = 0; j < n; j++) {
+                    results.words[(begin + j) >> 6] |= uint64_t(matched[j]) << ((begin + j) & 63);
+                }
+            }
+        });
+        return results;
+    }
+    
+#if __cplusplus >= 202002L
+    BitVector validateBatch(std::span<const std::string_view> inputs, ThreadPool& pool) const {
+        return validateBatch(inputs.data(), inputs.size(), pool);
+    }
+#endif
+    
+    // State reached from each possible start state after consuming data
+    std::vector<int32_t> stateMapping(const char* data, size_t length) const {
+        size_t numStates = dfaStates.size();
+        std::vector<int32_t> lanes(numStates);   // current state of each distinct lane
+        std::vector<int32_t> laneOf(numStates);  // start state -> lane, -1 once dead
+        for (size_t s = 0; s < numStates; s++) lanes[s] = laneOf[s] = s;
+        
+        const int32_t* next = table.data();
+        const uint8_t* classOf = classMap.data();
+        int shift = classShift;
+        const unsigned char* bytes = (const unsigned char*)data;
+        std::vector<int32_t> laneOfState(numStates, -1);
+        std::vector<int32_t> remap;
+        size_t mergeInterval = 16;
+        size_t pos = 0;
+        
+        while (pos < length && !lanes.empty()) {
+            size_t end = std::min(length, pos + mergeInterval);
+            for (; pos < end; pos++) {
+                uint8_t cls = classOf[bytes[pos]];
+                for (int32_t& s : lanes) {
+                    int32_t row = s & ~(s >> 31);
+                    s = next[((size_t)row << shift) + cls] | (s >> 31);
+                }
+            }
+            
+            // Merge lanes sitting in the same state and drop dead ones; back
+            // off while nothing merges
+            remap.resize(lanes.size());
+            size_t kept = 0;
+            for (size_t l = 0; l < lanes.size(); l++) {
+                int32_t s = lanes[l];
+                if (s == DEAD_STATE) {
+                    remap[l] = -1;
+                    continue;
+                }
+                if (laneOfState[s] == -1) {
+                    laneOfState[s] = kept;
+                    lanes[kept++] = s;
+                }
+                remap[l] = laneOfState[s];
+            }
+            for (size_t l = 0; l < kept; l++) laneOfState[lanes[l]] = -1;
+            
+            if (kept == lanes.size()) {
+                mergeInterval = std::min<size_t>(mergeInterval * 2, 1 << 16);
+                continue;
+            }
+            lanes.resize(kept);
+            for (int32_t& lane : laneOf) {
+                if (lane != -1) lane = remap[lane];
+            }
+        }
+        
+        std::vector<int32_t> result(numStates);
+        for (size_t s = 0; s < numStates; s++) {
+            result[s] = laneOf[s] == -1 ? DEAD_STATE : lanes[laneOf[s]];
+        }
+        return result;
+    }
+    
+    IdRange matchIds(int32_t state) const {
+        if (state == DEAD_STATE) return {nullptr, nullptr};
+        const int32_t* list = matchIdList.data();
+        return {list + matchIdStart[state], list + matchIdStart[state + 1]};
+    }
+    
+    // Every pattern id that matches the whole input, in one pass
+    IdRange matches(std::string_view str) const {
+        return matchIds(finalState(str));
+    }
+    
+    struct Match {
+        size_t start;
+        size_t end;
+    };
+    
+    // Length of the longest match anchored at data, or -1 if there is none
+    ptrdiff_t longestMatch(const char* data, size_t length) const {
+        const int32_t* next = table.data();
+        const uint8_t* classOf = classMap.data();
+        const unsigned char* bytes = (const unsigned char*)data;
+        int shift = classShift;
+        
+        int32_t state = startState;
+        ptrdiff_t longest = accepting[state] ? 0 : -1;
+        for (size_t i = 0; i < length; i++) {
+            state = next[((size_t)state << shift) + classOf[bytes[i]]];
+            if (state == DEAD_STATE) break;
+            if (accepting[state]) longest = i + 1;
+        }
+        return longest;
+    }
+    
+    // Leftmost-longest match starting at or after from. Candidate starts
+    // come from the prefilter, so most of the text is never run through
+    // the table. Without a prefilter but with a reverse DFA, one backward
+    // pass finds the leftmost start instead of trying every position.
+    bool find(std::string_view text, size_t from, Match& match) const {
+        if (prefilter.empty() && reverseDFA) {
+            size_t start = std::string_view::npos;
+            reverseDFA->scanStarts(text, from, [&](size_t pos) { start = pos; });
+            if (start == std::string_view::npos) return false;
+            match = {start, start + longestMatch(text.data() + start, text.size() - start)};
+            return true;
+        }
+        
+        size_t factorAt = 0;
+        bool skip = !prefilter.empty();
+        
+        for (size_t pos = from; pos <= text.size(); pos++) {
+            if (skip) {
+                pos = prefilter.next(text, pos, factorAt);
+                if (pos == std::string_view::npos) return false;
+            }
+            
+            ptrdiff_t length = longestMatch(text.data() + pos, text.size() - pos);
+            if (length >= 0) {
+                match = {pos, pos + length};
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // All non-overlapping leftmost-longest matches. Without a prefilter
+    // but with a reverse DFA, every match start in the text is marked in a
+    // single backward pass (one bit per byte), and only marked positions
+    // past the previous match are run forward to find their longest end.
+    std::vector<Match> findAll(std::string_view text) const {
+        std::vector<Match> result;
+        Match match;
+        size_t pos = 0;
+        
+        if (prefilter.empty() && reverseDFA) {
+            BitVector starts(text.size() + 1);
+            reverseDFA->scanStarts(text, 0, [&](size_t p) { starts.words[p >> 6] |= uint64_t(1) << (p & 63); });
+            for (size_t w = 0; w < starts.words.size(); w++) {
+                uint64_t bits = starts.words[w];
+                while (bits) {
+                    size_t start = w * 64 + __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    if (start < pos) continue;
+                    
+                    size_t end = start + longestMatch(text.data() + start, text.size() - start);
+                    result.push_back({start, end});
+                    pos = end > start ? end : end + 1;
+                }
+            }
+            return result;
+        }
+        
+        while (find(text, pos, match)) {
+            result.push_back(match);
+            pos = match.end > match.start ? match.end : match.end + 1;
+        }
+        return result;
+    }
+    
+    // Runs this (reverse) DFA from the end of text down to from and calls
+    // onAccept(pos) for every pos where it accepts after reading text[pos],
+    // in decreasing order, including text.size() if the start state
+    // accepts.
+    template <typename F>
+    void scanStarts(std::string_view text, size_t from, F onAccept) const {
+        const int32_t* next = table.data();
+        const uint8_t* classOf = classMap.data();
+        const unsigned char* bytes = (const unsigned char*)text.data();
+        int shift = classShift;
+        
+        int32_t state = startState;
+        if (accepting[state]) onAccept(text.size());
+        for (size_t i = text.size(); i > from; i--) {
+            state = next[((size_t)state << shift) + classOf[bytes[i - 1]]];
+            if (state == DEAD_STATE) return;
+            if (accepting[state]) onAccept(i - 1);
+        }
+    }
+
+    // Hopcroft partition refinement. Missing transitions go to an implicit
+    // sink state; states equivalent to the sink are dropped again, so the
+    // result is the minimal partial DFA, renumbered in BFS order.
+    DFA minimize() const {
+        int n = dfaStates.size();
+        int sink = n;
+        int total = n + 1;
+        int k = numClasses;
+        
+        // delta[s * k + a] over byte classes, plus reverse edges grouped by
+        // (class, target)
+        std::vector<int> delta((size_t)total * k, sink);
+        for (int s = 0; s < n; s++) {
+            for (int a = 0; a < k; a++) {
+                int32_t target = next(s, a);
+                if (target != DEAD_STATE) delta[(size_t)s * k + a] = target;
+            }
+        }
+        std::vector<int> revStart((size_t)k * total + 1, 0);
+        std::vector<int> revSource((size_t)k * total);
+        for (int s = 0; s < total; s++) {
+            for (int a = 0; a < k; a++) revStart[(size_t)a * total + delta[(size_t)s * k + a] + 1]++;
+        }
+        for (size_t i = 1; i < revStart.size(); i++) revStart[i] += revStart[i - 1];
+        std::vector<int> fill(revStart.begin(), revStart.end() - 1);
+        for (int s = 0; s < total; s++) {
+            for (int a = 0; a < k; a++) revSource[fill[(size_t)a * total + delta[(size_t)s * k + a]]++] = s;
+        }
+        
+        // Refinable partition: blocks are ranges [first, end) of elems;
+        // marked members are swapped to the front, up to mid. States start
+        // out grouped by the set of pattern ids they accept.
+        std::vector<int> elems(total), loc(total), blockOf(total);
+        std::vector<int> first, end, mid;
+        std::map<std::vector<int>, int> initialBlock;
+        std::vector<int> blockSize;
+        static const std::vector<int> noIds;
+        for (int s = 0; s < total; s++) {
+            const std::vector<int>& ids = s < n ? acceptIds[s] : noIds;
+            auto inserted = initialBlock.emplace(ids, (int)blockSize.size());
+            if (inserted.second) blockSize.push_back(0);
+            blockOf[s] = inserted.first->second;
+            blockSize[blockOf[s]]++;
+        }
+        for (int size : blockSize) {
+            int begin = first.empty() ? 0 : end.back();
+            first.push_back(begin);
+            end.push_back(begin + size);
+            mid.push_back(begin);
+        }
+        for (int s = 0; s < total; s++) {
+            int b = blockOf[s];
+            elems[mid[b]] = s;
+            loc[s] = mid[b]++;
+        }
+        mid = first;
+        
+        std::queue<std::pair<int, int>> work;
+        std::vector<std::vector<bool>> inWork;
+        auto addWork = [&](int block, int a) {
+            if (!inWork[block][a]) {
+                inWork[block][a] = true;
+                work.push({block, a});
+            }
+        };
+        inWork.assign(first.size(), std::vector<bool>(k, false));
+        int largest = 0;
+        for (size_t b = 1; b < first.size(); b++) {
+            if (end[b] - first[b] > end[largest] - first[largest]) largest = b;
+        }
+        for (size_t b = 0; b < first.size(); b++) {
+            if ((int)b == largest) continue;
+            for (int a = 0; a < k; a++) addWork(b, a);
+        }
+        
+        std::vector<int> touched;
+        std::vector<int> splitter;
+        while (!work.empty()) {
+            auto [block, a] = work.front();
+            work.pop();
+            inWork[block][a] = false;
+            
+            splitter.assign(elems.begin() + first[block], elems.begin() + end[block]);
+            for (int t : splitter) {
+                for (int i = revStart[(size_t)a * total + t]; i < revStart[(size_t)a * total + t + 1]; i++) {
+                    int p = revSource[i];
+                    int b = blockOf[p];
+                    if (loc[p] < mid[b]) continue;
+                    if (mid[b] == first[b]) touched.push_back(b);
+                    int other = elems[mid[b]];
+                    std::swap(elems[loc[p]], elems[mid[b]]);
+                    loc[other] = loc[p];
+                    loc[p] = mid[b];
+                    mid[b]++;
+                }
+            }
+            
+            for (int b : touched) {
+                if (mid[b] == end[b]) {
+                    mid[b] = first[b];
+                    continue;
+                }
+                // The smaller half becomes the new block
+                int z = first.size();
+                if (mid[b] - first[b] <= end[b] - mid[b]) {
+                    first.push_back(first[b]);
+                    end.push_back(mid[b]);
+                    first[b] = mid[b];
+                } else {
+                    first.push_back(mid[b]);
+                    end.push_back(end[b]);
+                    end[b] = mid[b];
+                }
+                mid.push_back(first[z]);
+                mid[b] = first[b];
+                for (int i = first[z]; i < end[z]; i++) blockOf[elems[i]] = z;
+                
+                inWork.push_back(std::vector<bool>(k, false));
+                for (int c = 0; c < k; c++) addWork(z, c);
+            }
+            touched.clear();
+        }
+        
+        // Renumber live blocks in BFS order from the start block
+        int deadBlock = blockOf[sink];
+        std::vector<int> newId(first.size(), -1);
+        std::vector<int> order;
+        DFA result;
+        result.alphabet = alphabet;
+        result.startState = 0;
+        result.numPatterns = numPatterns;
+        result.prefilter = prefilter;
+        result.reverseDFA = reverseDFA;
+        result.setClasses(classMap, numClasses);
+        
+        newId[blockOf[startState]] = 0;
+        order.push_back(blockOf[startState]);
+        for (size_t i = 0; i < order.size(); i++) {
+            int rep = elems[first[order[i]]];
+            result.addRow();
+            for (int a = 0; a < k; a++) {
+                int target = blockOf[delta[(size_t)rep * k + a]];
+                if (target == deadBlock) continue;
+                if (newId[target] == -1) {
+                    newId[target] = order.size();
+                    order.push_back(target);
+                }
+                result.next(i, a) = newId[target];
+            }
+        }
+        
+        result.dfaStates.resize(order.size());
+        result.acceptIds.resize(order.size());
+        for (size_t i = 0; i < order.size(); i++) {
+            int b = order[i];
+            if (elems[first[b]] != sink) result.acceptIds[i] = acceptIds[elems[first[b]]];
+            for (int j = first[b]; j < end[b]; j++) {
+                int s = elems[j];
+                if (s == sink) continue;
+                result.dfaStates[i].unionWith(dfaStates[s]);
+                if (acceptStates.count(s)) result.acceptStates.insert(i);
+            }
+            result.stateMap[result.dfaStates[i]] = i;
+        }
+        
+        result.freeze();
+        return result;
+    }
+};
+
+// Resumable matcher over a frozen DFA. Input can arrive in any number of
+// chunks (pipes, read() buffers, mmap'd files) without being concatenated;
+// feeding chunks one after another is equivalent to one validate() call.
+class DFAMatcher {
+public:
+    explicit DFAMatcher(const DFA& dfa) : dfa(&dfa), state(dfa.startState) {}
+    
+    void reset() { state = dfa->startState; }
+    
+    // Returns false once no continuation of the input can match
+    bool feed(const char* data, size_t length) {
+        if (state != DFA::DEAD_STATE) state = dfa->run(state, data, length);
+        return state != DFA::DEAD_STATE;
+    }
+    
+    bool feed(std::string_view chunk) { return feed(chunk.data(), chunk.size()); }
+    
+    // Whether everything fed so far matches; the matcher can keep going
+    bool finish() const {
+        return state != DFA::DEAD_STATE && dfa->accepting[state] != 0;
+    }
+    
+    DFA::IdRange matchIds() const { return dfa->matchIds(state); }
+    int32_t currentState() const { return state; }
+    
+private:
+    const DFA* dfa;
+    int32_t state;
+};
+
+// Matches a whole file through a read-only private mapping; no copy of the
+// contents is made. Throws runtime_error if the file cannot be mapped.
+inline bool validateFile(const DFA& dfa, const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + path);
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    
+    size_t length = info.st_size;
+    if (length == 0) {
+        close(fd);
+        return dfa.validate("");
+    }
+    
+    void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) throw std::runtime_error("cannot mmap " + path);
+    madvise(data, length, MADV_SEQUENTIAL);
+    
+    DFAMatcher matcher(dfa);
+    matcher.feed((const char*)data, length);
+    bool result = matcher.finish();
+    
+    munmap(data, length);
+    return result;
+}
+
+// Binary DFA file, written once by saveDFA() and mapped read-only by
+// MappedDFA so worker processes share the same pages. Sections follow the
+// header at 8-byte aligned offsets, in host byte order:
+//   table        int32_t[numStates * numColumns], DEAD_STATE for no move;
+//                numColumns is a power of two
+//   accept       uint8_t[numStates]
+//   columnMap    uint8_t[256], byte -> byte class (table column)
+//   matchIdStart int32_t[numStates + 1]
+//   matchIdList  int32_t[numMatchIds]
+// checksum is FNV-1a over every byte after the header.
+static constexpr char DFA_FILE_MAGIC[8] = {'T', 'O', 'C', 'D', 'F', 'A', '\0', '\0'};
+static constexpr uint32_t DFA_FILE_VERSION = 1;
+
+struct DFAFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t checksum;
+    int32_t startState;
+    uint32_t numStates;
+    uint32_t numColumns;
+    uint32_t numPatterns;
+    uint64_t numMatchIds;
+    uint64_t tableOffset;
+    uint64_t acceptOffset;
+    uint64_t columnMapOffset;
+    uint64_t matchIdStartOffset;
+    uint64_t matchIdListOffset;
+};
+
+inline uint64_t fnv1a64(const uint8_t* data, size_t length) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+// Throws runtime_error if the file cannot be written
+inline void saveDFA(const DFA& dfa, const std::string& path) {
+    DFAFileHeader header = {};
+    memcpy(header.magic, DFA_FILE_MAGIC, sizeof(header.magic));
+    header.version = DFA_FILE_VERSION;
+    header.headerSize = sizeof(DFAFileHeader);
+    header.startState = dfa.startState;
+    header.numStates = dfa.dfaStates.size();
+    header.numColumns = dfa.rowStride();
+    header.numPatterns = dfa.numPatterns;
+    header.numMatchIds = dfa.matchIdList.size();
+    
+    std::vector<uint8_t> file(sizeof(DFAFileHeader));
+    auto append = [&](const void* data, size_t length) {
+        file.resize((file.size() + 7) & ~size_t(7), 0);
+        uint64_t offset = file.size();
+        file.insert(file.end(), (const uint8_t*)data, (const uint8_t*)data + length);
+        return offset;
+    };
+    
+    header.tableOffset = append(dfa.table.data(), dfa.table.size() * sizeof(int32_t));
+    header.acceptOffset = append(dfa.accepting.data(), dfa.accepting.size());
+    header.columnMapOffset = append(dfa.classMap.data(), dfa.classMap.size());
+    header.matchIdStartOffset = append(dfa.matchIdStart.data(), dfa.matchIdStart.size() * sizeof(int32_t));
+    header.matchIdListOffset = append(dfa.matchIdList.data(), dfa.matchIdList.size() * sizeof(int32_t));
+    header.fileSize = file.size();
+    header.checksum = fnv1a64(file.data() + sizeof(DFAFileHeader), file.size() - sizeof(DFAFileHeader));
+    memcpy(file.data(), &header, sizeof(header));
+    
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char*)file.data(), file.size());
+    if (!out) throw std::runtime_error("cannot write " + path);
+}
+
+// A DFA file mapped read-only; matching reads the tables in place with no
+// parsing or copying. Throws runtime_error on a missing, truncated,
+// mismatched-version or corrupt file. Opening always checks the header,
+// section layout and byte classes. verify adds the checksum and a bounds
+// pass over every transition and match id range; skip it only for files
+// that were already verified, so that opening reads no more than the
+// header and matching faults in pages on demand.
+class MappedDFA {
+public:
+    explicit MappedDFA(const std::string& path, bool verify = true) : data(nullptr), length(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        
+        struct stat info;
+        if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(DFAFileHeader)) {
+            close(fd);
+            throw std::runtime_error("not a DFA file: " + path);
+        }
+        length = info.st_size;
+        
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mapped == MAP_FAILED) throw std::runtime_error("cannot mmap " + path);
+        data = (const uint8_t*)mapped;
+        
+        try {
+            check(verify);
+        } catch (...) {
+            munmap((void*)data, length);
+            throw;
+        }
+        
+        table = (const int32_t*)(data + header->tableOffset);
+        accept = data + header->acceptOffset;
+        columnMap = data + header->columnMapOffset;
+        matchIdStart = (const int32_t*)(data + header->matchIdStartOffset);
+        matchIdList = (const int32_t*)(data + header->matchIdListOffset);
+    }
+    
+    ~MappedDFA() {
+        if (data) munmap((void*)data, length);
+    }
+    
+    MappedDFA(const MappedDFA&) = delete;
+    MappedDFA& operator=(const MappedDFA&) = delete;
+    
+    int32_t finalState(std::string_view str) const {
+        int32_t currentState = header->startState;
+        int shift = __builtin_ctz(header->numColumns);
+        
+        for (unsigned char c : str) {
+            currentState = table[((size_t)currentState << shift) + columnMap[c]];
+            if (currentState == DFA::DEAD_STATE) return DFA::DEAD_STATE;
+        }
+        return currentState;
+    }
+    
+    bool validate(std::string_view str) const {
+        int32_t state = finalState(str);
+        return state != DFA::DEAD_STATE && accept[state] != 0;
+    }
+    
+    DFA::IdRange matches(std::string_view str) const {
+        int32_t state = finalState(str);
+        if (state == DFA::DEAD_STATE) return {nullptr, nullptr};
+        return {matchIdList + matchIdStart[state], matchIdList + matchIdStart[state + 1]};
+    }
+    
+    size_t numStates() const { return header->numStates; }
+    size_t numPatterns() const { return header->numPatterns; }
+    
+private:
+    const uint8_t* data;
+    size_t length;
+    const DFAFileHeader* header = nullptr;
+    const int32_t* table = nullptr;
+    const uint8_t* accept = nullptr;
+    const uint8_t* columnMap = nullptr;
+    const int32_t* matchIdStart = nullptr;
+    const int32_t* matchIdList = nullptr;
+    
+    void check(bool verify) {
+        header = (const DFAFileHeader*)data;
+        if (memcmp(header->magic, DFA_FILE_MAGIC, sizeof(header->magic)) != 0) {
+            throw std::runtime_error("not a DFA file");
+        }
+        if (header->version != DFA_FILE_VERSION || header->headerSize != sizeof(DFAFileHeader)) {
+            throw std::runtime_error("unsupported DFA file version " + std::to_string(header->version));
+        }
+        if (header->fileSize != length) throw std::runtime_error("truncated DFA file");
+        
+        auto fits = [&](uint64_t offset, uint64_t bytes) {
+            return offset % 8 == 0 && offset <= length && bytes <= length - offset;
+        };
+        uint64_t states = header->numStates;
+        uint32_t columns = header->numColumns;
+        if (states == 0 || columns == 0 || columns > 256 || (columns & (columns - 1)) != 0 ||
+            header->startState < 0 || (uint64_t)header->startState >= states ||
+            !fits(header->tableOffset, states * header->numColumns * sizeof(int32_t)) ||
+            !fits(header->acceptOffset, states) ||
+            !fits(header->columnMapOffset, 256) ||
+            !fits(header->matchIdStartOffset, (states + 1) * sizeof(int32_t)) ||
+            header->numMatchIds > length / sizeof(int32_t) ||
+            !fits(header->matchIdListOffset, header->numMatchIds * sizeof(int32_t))) {
+            throw std::runtime_error("corrupt DFA file layout");
+        }
+        
+        const uint8_t* map = data + header->columnMapOffset;
+        for (int c = 0; c < 256; c++) {
+            if (map[c] >= columns) throw std::runtime_error("corrupt DFA file: byte class out of range");
+        }
+        if (!verify) return;
+        
+        // Matching indexes with these values unchecked; the checksum alone
+        // would not catch a file that was written corrupt
+        const int32_t* cells = (const int32_t*)(data + header->tableOffset);
+        for (uint64_t k = 0; k < states * columns; k++) {
+            if (cells[k] != DFA::DEAD_STATE && (cells[k] < 0 || (uint64_t)cells[k] >= states)) {
+                throw std::runtime_error("corrupt DFA file: transition out of range");
+            }
+        }
+        const int32_t* starts = (const int32_t*)(data + header->matchIdStartOffset);
+        for (uint64_t k = 0; k <= states; k++) {
+            if (starts[k] < (k == 0 ? 0 : starts[k - 1]) || (uint64_t)starts[k] > header->numMatchIds) {
+                throw std::runtime_error("corrupt DFA file: match id range out of order");
+            }
+        }
+        
+        if (fnv1a64(data + sizeof(DFAFileHeader), length - sizeof(DFAFileHeader)) != header->checksum) {
+            throw std::runtime_error("DFA file checksum mismatch");
+        }
+    }
+};
+
+// Emits a standalone C++ source file that matches the same language as a
+// DFA without interpreting its tables at runtime. GOTO encodes every state
+// as a label with a switch over the next byte; TABLE emits a constexpr
+// transition table and a constexpr match loop.
+class DFACodeGenerator {
+public:
+    enum Style { GOTO, TABLE };
+    
+    std::string generate(const DFA& dfa, const std::string& functionName, Style style, const std::string& regex = "") {
+        std::stringstream ss;
+        ss << "// Generated DFA matcher";
+        if (!regex.empty()) ss << " for " << commentText(regex);
+        ss << "\n// " << dfa.dfaStates.size() << " states\n\n";
+        ss << "#include <cstdint>\n#include <string_view>\n\n";
+        
+        if (style == GOTO) {
+            generateGoto(ss, dfa, functionName);
+        } else {
+            generateTable(ss, dfa, functionName);
+        }
+        return ss.str();
+    }
+    
+private:
+    // The regex as text safe inside a // comment: a newline would end the
+    // comment early and a backslash before the line end (even with spaces
+    // between) would splice the next line into it, so '\\' and bytes
+    // outside printable ASCII become \xNN
+    static std::string commentText(const std::string& regex) {
+        std::string text;
+        for (unsigned char c : regex) {
+            if (c >= 0x20 && c < 0x7F && c != '\\') {
+                text += c;
+            } else {
+                text += "\\x";
+                text += "0123456789ABCDEF"[c >> 4];
+                text += "0123456789ABCDEF"[c & 15];
+            }
+        }
+        return text;
+    }
+    
+    static std::string byteLiteral(int c) {
+        if (isalnum(c)) return std::string("'") + (char)c + "'";
+        return std::to_string(c);
+    }
+    
+    void generateGoto(std::stringstream& ss, const DFA& dfa, const std::string& functionName) {
+        ss << "bool " << functionName << "(std::string_view input) {\n";
+        ss << "    const unsigned char* p = (const unsigned char*)input.data();\n";
+        ss << "    const unsigned char* end = p + input.size();\n";
+        ss << "    goto s" << dfa.startState << ";\n";
+        
+        for (size_t s = 0; s < dfa.dfaStates.size(); s++) {
+            ss << "s" << s << ":\n";
+            ss << "    if (p == end) return " << (dfa.accepting[s] ? "true" : "false") << ";\n";
+            ss << "    switch (*p++) {\n";
+            
+            // One group of case labels per target state
+            std::map<int32_t, std::vector<int>> byTarget;
+            for (int c = 0; c < 256; c++) {
+                int32_t target = dfa.next(s, dfa.classMap[c]);
+                if (target != DFA::DEAD_STATE) byTarget[target].push_back(c);
+            }
+            for (const auto& group : byTarget) {
+                ss << "       ";
+                for (int c : group.second) ss << " case " << byteLiteral(c) << ":";
+                ss << " goto s" << group.first << ";\n";
+            }
+            ss << "        default: return false;\n";
+            ss << "    }\n";
+        }
+        ss << "}\n";
+    }
+    
+    void generateTable(std::stringstream& ss, const DFA& dfa, const std::string& functionName) {
+        size_t numStates = dfa.dfaStates.size();
+        ss << "namespace " << functionName << "_dfa {\n\n";
+        ss << "constexpr unsigned char kClass[256] = {\n    ";
+        for (int c = 0; c < 256; c++) {
+            ss << (int)dfa.classMap[c] << (c < 255 ? (c % 32 == 31 ? ",\n    " : ", ") : "");
+        }
+        ss << "};\n\n";
+        
+        ss << "constexpr std::int32_t kTable[" << numStates << "][" << dfa.numClasses << "] = {\n";
+        for (size_t s = 0; s < numStates; s++) {
+            ss << "    {";
+            for (int a = 0; a < dfa.numClasses; a++) {
+                ss << dfa.next(s, a) << (a + 1 < dfa.numClasses ? ", " : "");
+            }
+            ss << "},\n";
+        }
+        ss << "};\n\n";
+        
+        ss << "constexpr bool kAccept[" << numStates << "] = {";
+        for (size_t s = 0; s < numStates; s++) {
+            ss << (dfa.accepting[s] ? "true" : "false") << (s + 1 < numStates ? ", " : "");
+        }
+        ss << "};\n\n";
+        ss << "}  // namespace " << functionName << "_dfa\n\n";
+        
+        ss << "constexpr bool " << functionName << "(std::string_view input) {\n";
+        ss << "    std::int32_t state = " << dfa.startState << ";\n";
+        ss << "    for (char c : input) {\n";
+        ss << "        state = " << functionName << "_dfa::kTable[state][" << functionName
+           << "_dfa::kClass[(unsigned char)c]];\n";
+        ss << "        if (state < 0) return false;\n";
+        ss << "    }\n";
+        ss << "    return " << functionName << "_dfa::kAccept[state];\n";
+        ss << "}\n";
+    }
+};
+
+// Lazily determinized DFA in the style of RE2: keeps the NFA and builds DFA
+// states only when input reaches them. States live in a cache bounded by
+// maxCacheBytes; when it fills up the cache is flushed and rebuilt from the
+// state currently being matched. Not thread-safe: validate() fills the cache.
+class LazyDFA {
+public:
+    static constexpr int32_t UNKNOWN_STATE = -2;
+    
+    LazyDFA(const NFA& nfa, size_t maxCacheBytes = 1 << 20)
+        : nfa(nfa), closures(nfa), classes(nfa), acceptMask(nfa.states.size()), flushCount(0) {
+        for (int s : nfa.acceptStates) acceptMask.insert(s);
+        classShift = 0;
+        while ((1 << classShift) < classes.count()) classShift++;
+        
+        // Table row, interned set stored twice (map key and states), and
+        // rough hash node overhead.
+        size_t setBytes = StateSet(nfa.states.size()).words.size() * sizeof(uint64_t);
+        size_t stateBytes = ((size_t)1 << classShift) * sizeof(int32_t) + 2 * setBytes + 64;
+        maxStates = std::max<size_t>(maxCacheBytes / stateBytes, 8);
+        
+        startSet = closures.of(nfa.startState);
+        startState = intern(startSet);
+    }
+    
+    bool validate(std::string_view str) {
+        int32_t currentState = startState;
+        
+        for (unsigned char c : str) {
+            int cls = classes.classOf[c];
+            int32_t next = table[((size_t)currentState << classShift) + cls];
+            if (next == UNKNOWN_STATE) next = computeNext(currentState, cls);
+            if (next == DFA::DEAD_STATE) return false;
+            currentState = next;
+        }
+        
+        return accepting[currentState] != 0;
+    }
+    
+    size_t cachedStates() const { return states.size(); }
+    size_t cacheCapacity() const { return maxStates; }
+    size_t flushes() const { return flushCount; }
+    
+private:
+    NFA nfa;
+    EpsilonClosures closures;
+    ByteClasses classes;
+    int classShift;
+    StateSet acceptMask;
+    StateSet startSet;
+    int32_t startState;
+    
+    std::unordered_map<StateSet, int, StateSetHash> stateMap;
+    std::vector<StateSet> states;
+    std::vector<int32_t> table;
+    std::vector<uint8_t> accepting;
+    size_t maxStates;
+    size_t flushCount;
+    
+    int32_t intern(const StateSet& set) {
+        auto inserted = stateMap.emplace(set, (int)states.size());
+        if (inserted.second) {
+            states.push_back(set);
+            table.resize(states.size() << classShift, UNKNOWN_STATE);
+            accepting.push_back(set.intersects(acceptMask));
+        }
+        return inserted.first->second;
+    }
+    
+    void flush() {
+        stateMap.clear();
+        states.clear();
+        table.clear();
+        accepting.clear();
+        flushCount++;
+        startState = intern(startSet);
+    }
+    
+    int32_t computeNext(int32_t currentState, int cls) {
+        StateSet next = closures.step(states[currentState], (char)classes.representative[cls], nfa);
+        if (next.empty()) {
+            table[((size_t)currentState << classShift) + cls] = DFA::DEAD_STATE;
+            return DFA::DEAD_STATE;
+        }
+        
+        if (!stateMap.count(next) && states.size() >= maxStates) {
+            StateSet current = states[currentState];
+            flush();
+            currentState = intern(current);
+        }
+        
+        int32_t nextState = intern(next);
+        table[((size_t)currentState << classShift) + cls] = nextState;
+        return nextState;
+    }
+};
+
+// Thompson NFA simulated directly, tracking the set of active states per
+// input position. The sets are sparse sets (dense list plus index array),
+// so clearing one is O(1) and a step only visits active states. Every
+// buffer is sized to the NFA up front and validate() never allocates, so
+// memory stays linear in the pattern however the input behaves. Not
+// thread-safe: validate() reuses the scratch sets.
+class NFASimulation {
+public:
+    NFASimulation() = default;
+    
+    explicit NFASimulation(const NFA& nfa) : startState(nfa.startState) {
+        size_t n = nfa.states.size();
+        transitionStart.push_back(0);
+        epsilonStart.push_back(0);
+        for (const NFAState& state : nfa.states) {
+            transitions.insert(transitions.end(), state.transitions.begin(), state.transitions.end());
+            epsilonTargets.insert(epsilonTargets.end(), state.epsilonTransitions.begin(), state.epsilonTransitions.end());
+            transitionStart.push_back(transitions.size());
+            epsilonStart.push_back(epsilonTargets.size());
+            accepting.push_back(state.isAccepting);
+        }
+        current = SparseSet(n);
+        next = SparseSet(n);
+        stack.resize(n);
+    }
+    
+    bool validate(std::string_view str) {
+        current.clear();
+        addClosure(current, startState);
+        
+        for (unsigned char c : str) {
+            next.clear();
+            for (size_t i = 0; i < current.size; i++) {
+                int s = current.dense[i];
+                for (int t = transitionStart[s]; t < transitionStart[s + 1]; t++) {
+                    if (transitions[t].covers(c)) addClosure(next, transitions[t].to);
+                }
+            }
+            std::swap(current, next);
+            if (current.size == 0) return false;
+        }
+        
+        for (size_t i = 0; i < current.size; i++) {
+            if (accepting[current.dense[i]]) return true;
+        }
+        return false;
+    }
+    
+    size_t states() const { return accepting.size(); }
+    
+    size_t memoryBytes() const {
+        return transitions.size() * sizeof(Transition)
+            + (transitionStart.size() + epsilonStart.size() + epsilonTargets.size() + stack.size()) * sizeof(int)
+            + accepting.size()
+            + 2 * 2 * accepting.size() * sizeof(int);
+    }
+
+private:
+    struct SparseSet {
+        std::vector<int> dense;
+        std::vector<int> sparse;
+        size_t size = 0;
+        
+        SparseSet() {}
+        explicit SparseSet(size_t n) : dense(n), sparse(n) {}
+        
+        bool contains(int s) const {
+            return (size_t)sparse[s] < size && dense[sparse[s]] == s;
+        }
+        
+        void insert(int s) {
+            sparse[s] = size;
+            dense[size++] = s;
+        }
+        
+        void clear() { size = 0; }
+    };
+    
+    std::vector<Transition> transitions;  // per state, ranges from transitionStart
+    std::vector<int> transitionStart;
+    std::vector<int> epsilonTargets;
+    std::vector<int> epsilonStart;
+    std::vector<uint8_t> accepting;
+    int startState = 0;
+    
+    SparseSet current, next;
+    std::vector<int> stack;
+    
+    // Each state enters a set at most once, so stack never needs more than
+    // one slot per NFA state.
+    void addClosure(SparseSet& set, int state) {
+        if (set.contains(state)) return;
+        set.insert(state);
+        size_t top = 0;
+        stack[top++] = state;
+        while (top > 0) {
+            int s = stack[--top];
+            for (int e = epsilonStart[s]; e < epsilonStart[s + 1]; e++) {
+                int target = epsilonTargets[e];
+                if (!set.contains(target)) {
+                    set.insert(target);
+                    stack[top++] = target;
+                }
+            }
+        }
+    }
+};
+
+// Regex syntax tree. Nodes are appended as the parser reduces them, so
+// children always come before their parents and one forward pass over
+// nodes visits the tree in post-order.
+// Bounded repetition is expanded into copies by the parser, so it has no
+// node kind of its own.
+struct RegexNode {
+    enum Kind { EMPTY, CHAR, CLASS, CONCAT, ALT, STAR, PLUS, QUEST };
+    
+    Kind kind;
+    char symbol;
+    int left;   // operand; the class index into RegexAST::classes for CLASS
+    int right;
+};
+
+struct ByteRange {
+    unsigned char lo;
+    unsigned char hi;
+};
+
+struct RegexAST {
+    std::vector<RegexNode> nodes;
+    std::vector<std::vector<ByteRange>> classes;  // sorted, disjoint, non-adjacent ranges
+    int root = -1;
+    
+    int add(RegexNode::Kind kind, char symbol = 0, int left = -1, int right = -1) {
+        nodes.push_back({kind, symbol, left, right});
+        return nodes.size() - 1;
+    }
+    
+    bool hasOperand(int node) const {
+        RegexNode::Kind kind = nodes[node].kind;
+        return kind != RegexNode::EMPTY && kind != RegexNode::CHAR && kind != RegexNode::CLASS;
+    }
+};
+
+// Glushkov position automaton simulated with one bit per position: a
+// state is the set of positions just matched, held in a single word. The
+// union of follow sets is looked up one byte of the state at a time, so a
+// step costs ceil(positions / 8) table loads regardless of how many
+// positions are active. Handles regexes with at most 64 positions.
+class BitParallelNFA {
+public:
+    static constexpr int MAX_POSITIONS = 64;
+    
+    BitParallelNFA() = default;
+    
+    explicit BitParallelNFA(const RegexAST& ast) {
+        positions = countPositions(ast);
+        if (positions > MAX_POSITIONS) return;
+        
+        std::vector<int> positionOf(ast.nodes.size(), -1);
+        std::vector<uint64_t> followOf(positions, 0);
+        std::vector<char> reachable = reachableNodes(ast);
+        std::vector<bool> nullableOf(ast.nodes.size());
+        std::vector<uint64_t> firstOf(ast.nodes.size()), lastOf(ast.nodes.size());
+        
+        auto addFollow = [&](uint64_t from, uint64_t to) {
+            for (; from; from &= from - 1) followOf[__builtin_ctzll(from)] |= to;
+        };
+        
+        int next = 0;
+        for (size_t i = 0; i < ast.nodes.size(); i++) {
+            if (!reachable[i]) continue;
+            const RegexNode& node = ast.nodes[i];
+            int l = node.left, r = node.right;
+            switch (node.kind) {
+            case RegexNode::EMPTY:
+                nullableOf[i] = true;
+                break;
+            case RegexNode::CHAR:
+                positionOf[i] = next;
+                firstOf[i] = lastOf[i] = 1ull << next;
+                charMask[(unsigned char)node.symbol] |= 1ull << next;
+                next++;
+                break;
+            case RegexNode::CLASS:
+                positionOf[i] = next;
+                firstOf[i] = lastOf[i] = 1ull << next;
+                for (ByteRange range : ast.classes[l]) {
+                    for (int c = range.lo; c <= range.hi; c++) charMask[c] |= 1ull << next;
+                }
+                next++;
+                break;
+            case RegexNode::CONCAT:
+                nullableOf[i] = nullableOf[l] && nullableOf[r];
+                firstOf[i] = firstOf[l] | (nullableOf[l] ? firstOf[r] : 0);
+                lastOf[i] = lastOf[r] | (nullableOf[r] ? lastOf[l] : 0);
+                addFollow(lastOf[l], firstOf[r]);
+                break;
+            case RegexNode::ALT:
+                nullableOf[i] = nullableOf[l] || nullableOf[r];
+                firstOf[i] = firstOf[l] | firstOf[r];
+                lastOf[i] = lastOf[l] | lastOf[r];
+                break;
+            case RegexNode::STAR:
+            case RegexNode::PLUS:
+                nullableOf[i] = node.kind == RegexNode::STAR || nullableOf[l];
+                firstOf[i] = firstOf[l];
+                lastOf[i] = lastOf[l];
+                addFollow(lastOf[l], firstOf[l]);
+                break;
+            case RegexNode::QUEST:
+                nullableOf[i] = true;
+                firstOf[i] = firstOf[l];
+                lastOf[i] = lastOf[l];
+                break;
+            }
+        }
+        
+        nullable = nullableOf[ast.root];
+        first = firstOf[ast.root];
+        last = lastOf[ast.root];
+        
+        // follow[k][b]: union of follow sets of the positions in byte k
+        chunks = (positions + 7) / 8;
+        follow.assign((size_t)chunks * 256, 0);
+        for (int k = 0; k < chunks; k++) {
+            for (int b = 0; b < 256; b++) {
+                uint64_t reach = 0;
+                for (int bit = 0; bit < 8 && k * 8 + bit < positions; bit++) {
+                    if (b & (1 << bit)) reach |= followOf[k * 8 + bit];
+                }
+                follow[k * 256 + b] = reach;
+            }
+        }
+    }
+    
+    bool fits() const { return positions <= MAX_POSITIONS; }
+    int positionCount() const { return positions; }
+    
+    bool validate(std::string_view str) const {
+        if (str.empty()) return nullable;
+        
+        const unsigned char* bytes = (const unsigned char*)str.data();
+        const uint64_t* table = follow.data();
+        uint64_t active = first & charMask[bytes[0]];
+        for (size_t i = 1; i < str.size() && active; i++) {
+            uint64_t reach = 0;
+            for (int k = 0; k < chunks; k++) {
+                reach |= table[k * 256 + ((active >> (8 * k)) & 0xff)];
+            }
+            active = reach & charMask[bytes[i]];
+        }
+        return (active & last) != 0;
+    }
+    
+    // Only the nodes hanging off the root take part in matching
+    static std::vector<char> reachableNodes(const RegexAST& ast) {
+        std::vector<char> reachable(ast.nodes.size(), 0);
+        reachable[ast.root] = 1;
+        for (size_t i = ast.nodes.size(); i-- > 0;) {
+            if (!reachable[i] || !ast.hasOperand(i)) continue;
+            reachable[ast.nodes[i].left] = 1;
+            if (ast.nodes[i].right >= 0) reachable[ast.nodes[i].right] = 1;
+        }
+        return reachable;
+    }
+    
+    static int countPositions(const RegexAST& ast) {
+        std::vector<char> reachable = reachableNodes(ast);
+        int count = 0;
+        for (size_t i = 0; i < ast.nodes.size(); i++) {
+            RegexNode::Kind kind = ast.nodes[i].kind;
+            if (reachable[i] && (kind == RegexNode::CHAR || kind == RegexNode::CLASS)) count++;
+        }
+        return count;
+    }
+    
+private:
+    int positions = 0;
+    int chunks = 0;
+    bool nullable = false;
+    uint64_t first = 0;
+    uint64_t last = 0;
+    std::array<uint64_t, 256> charMask{};
+    std::vector<uint64_t> follow;
+};
+
+// Whichever engine RegexToDFA::convertAuto() picked for a pattern
+class Matcher {
+public:
+    enum Engine { TABLE_DFA, BIT_PARALLEL, LAZY_DFA, NFA_SIMULATION };
+    
+    explicit Matcher(DFA dfa) : kind(TABLE_DFA), dfa(std::move(dfa)) {}
+    explicit Matcher(BitParallelNFA nfa) : kind(BIT_PARALLEL), bitParallel(std::move(nfa)) {}
+    explicit Matcher(LazyDFA lazyDFA) : kind(LAZY_DFA), lazy(new LazyDFA(std::move(lazyDFA))) {}
+    explicit Matcher(NFASimulation nfa) : kind(NFA_SIMULATION), simulation(std::move(nfa)) {}
+    
+    Engine engine() const { return kind; }
+    
+    const char* engineName() const {
+        switch (kind) {
+        case TABLE_DFA:      return "DFA";
+        case BIT_PARALLEL:   return "bit-parallel NFA";
+        case LAZY_DFA:       return "lazy DFA";
+        case NFA_SIMULATION: return "NFA simulation";
+        }
+        return "";
+    }
+    
+    bool validate(std::string_view str) {
+        switch (kind) {
+        case TABLE_DFA:      return dfa.validate(str);
+        case BIT_PARALLEL:   return bitParallel.validate(str);
+        case LAZY_DFA:       return lazy->validate(str);
+        case NFA_SIMULATION: return simulation.validate(str);
+        }
+        return false;
+    }
+    
+private:
+    Engine kind;
+    DFA dfa;
+    BitParallelNFA bitParallel;
+    std::unique_ptr<LazyDFA> lazy;
+    NFASimulation simulation;
+};
+
+// Limits on subset construction; 0 means unlimited. maxBytes is checked
+// against the per-state estimate behind ConvertStats::dfaBytes.
+struct DFABudget {
+    size_t maxStates = 0;
+    size_t maxBytes = 0;
+    
+    bool limited() const { return maxStates || maxBytes; }
+};
+
+// Thrown by RegexToDFA::convert() when determinization would exceed the
+// budget. The partial DFA has already been released.
+class DFABudgetExceeded : public std::runtime_error {
+public:
+    explicit DFABudgetExceeded(const std::string& what) : std::runtime_error(what) {}
+};
+
+// What the last RegexToDFA call did, phase by phase. Times are wall-clock
+// milliseconds. Byte counts are estimated from container sizes, with 32
+// bytes of tree or hash node overhead per element.
+struct ConvertStats {
+    double parseMs = 0;
+    double literalMs = 0;       // literal analysis for the prefilter
+    double thompsonMs = 0;
+    double closureMs = 0;       // epsilon-closure precomputation
+    double subsetMs = 0;        // subset construction and freeze()
+    
+    size_t nfaStates = 0;
+    size_t nfaTransitions = 0;  // symbol transitions, one per byte range
+    size_t nfaEpsilonTransitions = 0;
+    size_t closureComputations = 0;  // state sets closed over epsilon edges
+    size_t dfaStates = 0;
+    size_t internLookups = 0;   // non-empty successor sets looked up in stateMap
+    size_t hashCollisions = 0;  // stateMap entries sharing a bucket with another
+    size_t nfaBytes = 0;
+    size_t closureBytes = 0;
+    size_t dfaBytes = 0;
+    
+    double totalMs() const { return parseMs + literalMs + thompsonMs + closureMs + subsetMs; }
+    
+    void print() const {
+        std::cout << std::fixed << std::setprecision(3)
+             << "  Parse:              " << std::setw(10) << parseMs << " ms" << std::endl
+             << "  Literal analysis:   " << std::setw(10) << literalMs << " ms" << std::endl
+             << "  Thompson:           " << std::setw(10) << thompsonMs << " ms" << std::endl
+             << "  Epsilon closures:   " << std::setw(10) << closureMs << " ms" << std::endl
+             << "  Subset:             " << std::setw(10) << subsetMs << " ms" << std::endl
+             << "  NFA:                " << nfaStates << " states, " << nfaTransitions << " transitions, "
+             << nfaEpsilonTransitions << " epsilon, ~" << nfaBytes << " bytes" << std::endl
+             << "  Closures computed:  " << closureComputations << " (~" << closureBytes << " bytes precomputed)" << std::endl
+             << "  DFA:                " << dfaStates << " states, ~" << dfaBytes << " bytes" << std::endl
+             << "  Interning:          " << internLookups << " lookups, " << hashCollisions << " hash collisions" << std::endl;
+    }
+    
+    std::string toJSON() const {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(3)
+           << "{\"parse_ms\": " << parseMs << ", \"literal_ms\": " << literalMs
+           << ", \"thompson_ms\": " << thompsonMs << ", \"closure_ms\": " << closureMs
+           << ", \"subset_ms\": " << subsetMs << ", \"total_ms\": " << totalMs()
+           << ", \"nfa_states\": " << nfaStates << ", \"nfa_transitions\": " << nfaTransitions
+           << ", \"nfa_epsilon_transitions\": " << nfaEpsilonTransitions
+           << ", \"closure_computations\": " << closureComputations
+           << ", \"dfa_states\": " << dfaStates << ", \"intern_lookups\": " << internLookups
+           << ", \"hash_collisions\": " << hashCollisions << ", \"nfa_bytes\": " << nfaBytes
+           << ", \"closure_bytes\": " << closureBytes << ", \"dfa_bytes\": " << dfaBytes << "}";
+        return ss.str();
+    }
+};
+
+class RegexToDFA {
+private:
+    std::string regex;
+    ConvertStats lastStats;
+    
+    static double millisecondsSince(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    }
+    
+    void recordNFA(const NFA& nfa) {
+        const size_t NODE = 32;
+        lastStats.nfaStates = nfa.states.size();
+        lastStats.nfaTransitions = lastStats.nfaEpsilonTransitions = 0;
+        lastStats.nfaBytes = nfa.states.capacity() * sizeof(NFAState);
+        for (const NFAState& state : nfa.states) {
+            lastStats.nfaTransitions += state.transitions.size();
+            lastStats.nfaBytes += state.transitions.capacity() * sizeof(Transition);
+            lastStats.nfaEpsilonTransitions += state.epsilonTransitions.size();
+            lastStats.nfaBytes += state.epsilonTransitions.size() * (NODE + sizeof(int));
+        }
+    }
+    
+    StateSet epsilonClosure(const StateSet& states, const NFA& nfa) {
+        StateSet closure = states;
+        std::vector<int> stack;
+        
+        states.forEach([&](int s) { stack.push_back(s); });
+        
+        while (!stack.empty()) {
+            int state = stack.back();
+            stack.pop_back();
+            
+            for (int eps : nfa.states[state].epsilonTransitions) {
+                if (!closure.contains(eps)) {
+                    closure.insert(eps);
+                    stack.push_back(eps);
+                }
+            }
+        }
+        
+        return closure;
+    }
+    
+    StateSet move(const StateSet& states, char symbol, const NFA& nfa) {
+        StateSet result(nfa.states.size());
+        
+        states.forEach([&](int s) {
+            for (const Transition& trans : nfa.states[s].transitions) {
+                if (trans.covers(symbol)) result.insert(trans.to);
+            }
+        });
+        
+        return result;
+    }
+    
+    // Thompson construction on a single state arena: each operator links
+    // existing fragments by their (start, accept) handles and adds at most
+    // two states, so no sub-automaton is ever copied.
+    Fragment charNFA(NFA& nfa, char c) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        nfa.addTransition(start, c, end);
+        return {start, end};
+    }
+    
+    Fragment classNFA(NFA& nfa, const std::vector<ByteRange>& ranges) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        for (ByteRange range : ranges) nfa.addRangeTransition(start, range.lo, range.hi, end);
+        return {start, end};
+    }
+    
+    Fragment emptyNFA(NFA& nfa) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        nfa.addEpsilonTransition(start, end);
+        return {start, end};
+    }
+    
+    Fragment concatenate(NFA& nfa, Fragment frag1, Fragment frag2) {
+        nfa.addEpsilonTransition(frag1.accept, frag2.start);
+        return {frag1.start, frag2.accept};
+    }
+    
+    Fragment alternate(NFA& nfa, Fragment frag1, Fragment frag2) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        
+        nfa.addEpsilonTransition(start, frag1.start);
+        nfa.addEpsilonTransition(start, frag2.start);
+        nfa.addEpsilonTransition(frag1.accept, end);
+        nfa.addEpsilonTransition(frag2.accept, end);
+        
+        return {start, end};
+    }
+    
+    Fragment star(NFA& nfa, Fragment frag) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        
+        nfa.addEpsilonTransition(start, frag.start);
+        nfa.addEpsilonTransition(start, end);
+        nfa.addEpsilonTransition(frag.accept, end);
+        nfa.addEpsilonTransition(frag.accept, frag.start);
+        
+        return {start, end};
+    }
+    
+    Fragment plus(NFA& nfa, Fragment frag) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        
+        nfa.addEpsilonTransition(start, frag.start);
+        nfa.addEpsilonTransition(frag.accept, end);
+        nfa.addEpsilonTransition(frag.accept, frag.start);
+        
+        return {start, end};
+    }
+    
+    Fragment optional(NFA& nfa, Fragment frag) {
+        int start = nfa.addState();
+        int end = nfa.addState();
+        
+        nfa.addEpsilonTransition(start, frag.start);
+        nfa.addEpsilonTransition(start, end);
+        nfa.addEpsilonTransition(frag.accept, end);
+        
+        return {start, end};
+    }
+    
+    // Builds every node's fragment in post-order; the fragment of the root
+    // is the whole regex.
+    Fragment compile(NFA& nfa, const RegexAST& ast) {
+        std::vector<Fragment> frags(ast.nodes.size());
+        for (size_t i = 0; i < ast.nodes.size(); i++) {
+            const RegexNode& node = ast.nodes[i];
+            switch (node.kind) {
+            case RegexNode::EMPTY:  frags[i] = emptyNFA(nfa); break;
+            case RegexNode::CHAR:   frags[i] = charNFA(nfa, node.symbol); break;
+            case RegexNode::CLASS:  frags[i] = classNFA(nfa, ast.classes[node.left]); break;
+            case RegexNode::CONCAT: frags[i] = concatenate(nfa, frags[node.left], frags[node.right]); break;
+            case RegexNode::ALT:    frags[i] = alternate(nfa, frags[node.left], frags[node.right]); break;
+            case RegexNode::STAR:   frags[i] = star(nfa, frags[node.left]); break;
+            case RegexNode::PLUS:   frags[i] = plus(nfa, frags[node.left]); break;
+            case RegexNode::QUEST:  frags[i] = optional(nfa, frags[node.left]); break;
+            }
+        }
+        return frags[ast.root];
+    }
+    
+    NFA thompson(const RegexAST& ast) {
+        auto begin = std::chrono::steady_clock::now();
+        NFA nfa;
+        nfa.states.reserve(ast.nodes.size() * 2 + 2);
+        
+        Fragment result = compile(nfa, ast);
+        nfa.startState = result.start;
+        nfa.setAccepting(result.accept);
+        lastStats.thompsonMs += millisecondsSince(begin);
+        recordNFA(nfa);
+        return nfa;
+    }
+    
+    // One NFA for all patterns: a shared root alternates into each pattern's
+    // fragment, and pattern i's accept state is tagged with match id i.
+    NFA thompson(const std::vector<RegexAST>& asts) {
+        auto begin = std::chrono::steady_clock::now();
+        NFA nfa;
+        size_t totalNodes = 0;
+        for (const RegexAST& ast : asts) totalNodes += ast.nodes.size();
+        nfa.states.reserve(totalNodes * 2 + 2 * asts.size() + 1);
+        
+        nfa.startState = nfa.addState();
+        for (size_t i = 0; i < asts.size(); i++) {
+            Fragment frag = compile(nfa, asts[i]);
+            nfa.addEpsilonTransition(nfa.startState, frag.start);
+            nfa.setAccepting(frag.accept, i);
+        }
+        lastStats.thompsonMs += millisecondsSince(begin);
+        recordNFA(nfa);
+        return nfa;
+    }
+    
+    NFA parseRegex(const std::string& regex) {
+        return thompson(parse(regex));
+    }
+    
+    // Upper bounds on n and m in x{n,m}, and on the tree once repetitions
+    // are expanded (each one copies x, so nesting multiplies)
+    static constexpr int MAX_REPEAT = 1000;
+    static constexpr size_t MAX_NODES = 1 << 20;
+    
+    // Shunting-yard over node indices. Concatenation is an implicit
+    // operator ('.') that binds tighter than '|'. Besides alphanumerics,
+    // '|', '*' and parentheses this accepts '+', '?', x{n}, x{n,} and
+    // x{n,m}, character classes ([a-z0-9], [^...]) and '\' escapes.
+    // Non-ASCII characters are read as UTF-8 and compiled to the bytes of
+    // their encoding, so matching never decodes. \xHH, or '\' before a
+    // byte that does not start valid UTF-8, matches that raw byte. Any
+    // other byte (such as '.', '^' or '$'), a '{' without a count, a
+    // malformed class or repetition count and an unescaped invalid UTF-8
+    // sequence throw runtime_error rather than being dropped.
+    RegexAST parse(const std::string& regex) {
+        auto begin = std::chrono::steady_clock::now();
+        RegexAST ast;
+        ast.nodes.reserve(regex.length() * 2 + 1);
+        std::stack<int> nodeStack;
+        std::stack<char> opStack;
+        bool needConcat = false;
+        
+        for (size_t i = 0; i < regex.length(); i++) {
+            char c = regex[i];
+            bool escaped = c == '\\' && i + 1 < regex.length();
+            
+            if (escaped || (unsigned char)c >= 0x80 || isalnum(c)) {
+                if (needConcat) pushOperator('.', ast, opStack, nodeStack);
+                bool raw;
+                uint32_t cp = readChar(regex, i, raw);
+                nodeStack.push(raw ? ast.add(RegexNode::CHAR, (char)cp) : utf8Literal(ast, cp));
+                i--;
+                needConcat = true;
+            } else if (c == '[') {
+                if (needConcat) pushOperator('.', ast, opStack, nodeStack);
+                nodeStack.push(parseClass(regex, i, ast));
+                needConcat = true;
+            } else if (c == '(') {
+                if (needConcat) pushOperator('.', ast, opStack, nodeStack);
+                opStack.push(c);
+                needConcat = false;
+            } else if (c == ')') {
+                while (!opStack.empty() && opStack.top() != '(') {
+                    processOperator(opStack.top(), ast, nodeStack);
+                    opStack.pop();
+                }
+                if (!opStack.empty()) opStack.pop();
+                needConcat = true;
+            } else if (c == '|') {
+                pushOperator('|', ast, opStack, nodeStack);
+                needConcat = false;
+            } else if (c == '*' || c == '+' || c == '?') {
+                if (!nodeStack.empty()) {
+                    int node = nodeStack.top();
+                    nodeStack.pop();
+                    RegexNode::Kind kind = c == '*' ? RegexNode::STAR : c == '+' ? RegexNode::PLUS : RegexNode::QUEST;
+                    nodeStack.push(ast.add(kind, 0, node));
+                }
+            } else if (c == '{') {
+                int min, max;
+                if (!parseRepeat(regex, i, min, max)) {
+                    throw std::runtime_error("unsupported regex character '{' without a count in " + regex);
+                }
+                if (!nodeStack.empty()) {
+                    int node = nodeStack.top();
+                    nodeStack.pop();
+                    nodeStack.push(repeat(ast, node, min, max));
+                }
+            } else {
+                throw std::runtime_error("unsupported regex character '" + std::string(1, c) + "' in " + regex);
+            }
+        }
+        
+        while (!opStack.empty()) {
+            processOperator(opStack.top(), ast, nodeStack);
+            opStack.pop();
+        }
+        
+        ast.root = nodeStack.empty() ? ast.add(RegexNode::EMPTY) : nodeStack.top();
+        lastStats.parseMs += millisecondsSince(begin);
+        return ast;
+    }
+    
+    // [abc], [a-z0-9] or [^...], with i on the '['; leaves i on the ']'
+    // and returns the class's node. A ']' right after the opening bracket
+    // and a '-' at either end are literal. A class matches one UTF-8
+    // encoded character or one of its raw \xHH bytes. [^...] is always
+    // taken over all of Unicode, so [^a] matches "é" but never a lone
+    // byte. A complement of characters cannot exclude a raw byte, so
+    // [^...] rejects \xHH at or above 0x80. An all-ASCII class compiles
+    // to a single byte range.
+    int parseClass(const std::string& regex, size_t& i, RegexAST& ast) {
+        size_t n = regex.length();
+        bool negate = ++i < n && regex[i] == '^';
+        if (negate) i++;
+        
+        std::vector<std::pair<uint32_t, uint32_t>> ranges;
+        std::vector<ByteRange> rawBytes;
+        for (bool first = true; i >= n || regex[i] != ']' || first; first = false) {
+            if (i >= n) throw std::runtime_error("unterminated character class in " + regex);
+            bool rawLo, rawHi;
+            uint32_t lo = readChar(regex, i, rawLo);
+            uint32_t hi = lo;
+            rawHi = rawLo;
+            if (i + 1 < n && regex[i] == '-' && regex[i + 1] != ']') {
+                i++;
+                hi = readChar(regex, i, rawHi);
+                if (hi < lo) throw std::runtime_error("reversed range in character class in " + regex);
+            }
+            if (rawLo != rawHi && lo >= 0x80) {
+                throw std::runtime_error("range mixes a character and a raw byte in " + regex);
+            }
+            if (negate && rawHi) {
+                throw std::runtime_error("raw byte in negated character class in " + regex);
+            }
+            if (!rawHi) {
+                ranges.push_back({lo, hi});
+                continue;
+            }
+            if (lo < 0x80) {
+                ranges.push_back({lo, 0x7F});
+                lo = 0x80;
+            }
+            rawBytes.push_back({(unsigned char)lo, (unsigned char)hi});
+        }
+        
+        // Without non-ASCII characters or negation the class is over
+        // bytes, so raw bytes join the ranges
+        bool unicode = negate;
+        for (auto range : ranges) unicode |= range.second >= 0x80;
+        if (!unicode) {
+            for (ByteRange range : rawBytes) ranges.push_back({range.lo, range.hi});
+            rawBytes.clear();
+        }
+        
+        std::sort(ranges.begin(), ranges.end());
+        std::vector<std::pair<uint32_t, uint32_t>> merged;
+        for (auto range : ranges) {
+            if (!merged.empty() && range.first <= merged.back().second + 1) {
+                merged.back().second = std::max(merged.back().second, range.second);
+            } else {
+                merged.push_back(range);
+            }
+        }
+        if (negate) {
+            std::vector<std::pair<uint32_t, uint32_t>> complement;
+            uint32_t next = 0;
+            for (auto range : merged) {
+                if (range.first > next) complement.push_back({next, range.first - 1});
+                next = range.second + 1;
+            }
+            if (next <= 0x10FFFF) complement.push_back({next, 0x10FFFF});
+            merged = complement;
+        }
+        
+        if (unicode) return utf8Class(ast, merged, rawBytes);
+        std::vector<ByteRange> bytes;
+        for (auto range : merged) bytes.push_back({(unsigned char)range.first, (unsigned char)range.second});
+        ast.classes.push_back(bytes);
+        return ast.add(RegexNode::CLASS, 0, ast.classes.size() - 1);
+    }
+    
+    // One pattern character at regex[i], after a '\' if escaped; moves i
+    // past it. \xHH, or an escaped byte that does not start valid UTF-8,
+    // sets raw and returns the byte, which then matches only itself.
+    static uint32_t readChar(const std::string& regex, size_t& i, bool& raw) {
+        raw = false;
+        bool escaped = regex[i] == '\\' && i + 1 < regex.length();
+        if (escaped) i++;
+        if (escaped && regex[i] == 'x' && i + 2 < regex.length() && isxdigit(regex[i + 1]) && isxdigit(regex[i + 2])) {
+            uint32_t byte = std::stoi(regex.substr(i + 1, 2), nullptr, 16);
+            i += 3;
+            raw = byte >= 0x80;
+            return byte;
+        }
+        
+        uint32_t cp;
+        if (decodeUTF8(regex, i, cp)) return cp;
+        if (!escaped) throw std::runtime_error("invalid UTF-8 in " + regex);
+        raw = true;
+        return (unsigned char)regex[i++];
+    }
+    
+    // Decodes the UTF-8 sequence at regex[i] into cp and moves i past it.
+    // Returns false, leaving i alone, on truncated, overlong or surrogate
+    // encodings.
+    static bool decodeUTF8(const std::string& regex, size_t& i, uint32_t& cp) {
+        static const uint32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        unsigned char lead = regex[i];
+        int length = lead < 0x80 ? 1 : lead < 0xC2 ? 0 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : lead < 0xF5 ? 4 : 0;
+        if (length == 0 || i + length > regex.length()) return false;
+        
+        cp = length == 1 ? lead : lead & (0x7F >> length);
+        for (int k = 1; k < length; k++) {
+            unsigned char c = regex[i + k];
+            if ((c & 0xC0) != 0x80) return false;
+            cp = cp << 6 | (c & 0x3F);
+        }
+        if (cp < minimum[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return false;
+        i += length;
+        return true;
+    }
+    
+    static int encodeUTF8(uint32_t cp, unsigned char* out) {
+        if (cp < 0x80) {
+            out[0] = cp;
+            return 1;
+        }
+        static const unsigned char leadBits[] = {0, 0, 0xC0, 0xE0, 0xF0};
+        int length = cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        for (int k = length - 1; k > 0; k--, cp >>= 6) out[k] = 0x80 | (cp & 0x3F);
+        out[0] = leadBits[length] | cp;
+        return length;
+    }
+    
+    // Splits the code points [lo, hi] into byte-range sequences whose
+    // concatenations match exactly their UTF-8 encodings, e.g. U+03B1 to
+    // U+03C9 becomes CE [B1-BF] | CF [80-89]. The range is first cut where
+    // the encoded length changes, then wherever lo and hi differ in a
+    // leading byte without spanning every continuation byte below it.
+    static void utf8Sequences(uint32_t lo, uint32_t hi, std::vector<std::vector<ByteRange>>& out) {
+        if (lo > hi) return;
+        if (lo <= 0xDFFF && hi >= 0xD800) {
+            if (lo < 0xD800) utf8Sequences(lo, 0xD7FF, out);
+            if (hi > 0xDFFF) utf8Sequences(0xE000, hi, out);
+            return;
+        }
+        for (uint32_t boundary : {0x7Fu, 0x7FFu, 0xFFFFu}) {
+            if (lo <= boundary && boundary < hi) {
+                utf8Sequences(lo, boundary, out);
+                utf8Sequences(boundary + 1, hi, out);
+                return;
+            }
+        }
+        for (int k = 1; k < 4; k++) {
+            uint32_t low = (1u << (6 * k)) - 1;
+            if ((lo & ~low) == (hi & ~low)) continue;
+            if ((lo & low) != 0) {
+                utf8Sequences(lo, lo | low, out);
+                utf8Sequences((lo | low) + 1, hi, out);
+                return;
+            }
+            if ((hi & low) != low) {
+                utf8Sequences(lo, (hi & ~low) - 1, out);
+                utf8Sequences(hi & ~low, hi, out);
+                return;
+            }
+        }
+        
+        unsigned char first[4], last[4];
+        int length = encodeUTF8(lo, first);
+        encodeUTF8(hi, last);
+        std::vector<ByteRange> sequence;
+        for (int k = 0; k < length; k++) sequence.push_back({first[k], last[k]});
+        out.push_back(sequence);
+    }
+    
+    // The bytes of one character's encoding, concatenated
+    int utf8Literal(RegexAST& ast, uint32_t cp) {
+        unsigned char bytes[4];
+        int length = encodeUTF8(cp, bytes);
+        int node = ast.add(RegexNode::CHAR, bytes[0]);
+        for (int k = 1; k < length; k++) {
+            node = ast.add(RegexNode::CONCAT, 0, node, ast.add(RegexNode::CHAR, bytes[k]));
+        }
+        return node;
+    }
+    
+    // Alternation of the byte sequences encoding the code point ranges,
+    // plus the given single bytes. Positions that allow a single byte
+    // become CHAR nodes, so literal analysis still sees shared lead bytes.
+    int utf8Class(RegexAST& ast, const std::vector<std::pair<uint32_t, uint32_t>>& ranges, std::vector<ByteRange> bytes) {
+        std::vector<std::vector<ByteRange>> sequences;
+        for (auto range : ranges) utf8Sequences(range.first, range.second, sequences);
+        
+        int result = -1;
+        if (!bytes.empty()) {
+            if (bytes.size() == 1 && bytes[0].lo == bytes[0].hi) {
+                result = ast.add(RegexNode::CHAR, bytes[0].lo);
+            } else {
+                ast.classes.push_back(bytes);
+                result = ast.add(RegexNode::CLASS, 0, ast.classes.size() - 1);
+            }
+        }
+        for (const std::vector<ByteRange>& sequence : sequences) {
+            int node = -1;
+            for (ByteRange range : sequence) {
+                int part;
+                if (range.lo == range.hi) {
+                    part = ast.add(RegexNode::CHAR, range.lo);
+                } else {
+                    ast.classes.push_back({range});
+                    part = ast.add(RegexNode::CLASS, 0, ast.classes.size() - 1);
+                }
+                node = node < 0 ? part : ast.add(RegexNode::CONCAT, 0, node, part);
+            }
+            result = result < 0 ? node : ast.add(RegexNode::ALT, 0, result, node);
+        }
+        if (result < 0) {
+            ast.classes.push_back({});
+            result = ast.add(RegexNode::CLASS, 0, ast.classes.size() - 1);
+        }
+        return result;
+    }
+    
+    // {n}, {n,} or {n,m} with i on the '{'. Returns false, leaving i alone,
+    // if no count follows; max is -1 when unbounded.
+    bool parseRepeat(const std::string& regex, size_t& i, int& min, int& max) {
+        size_t j = i + 1;
+        auto number = [&](int& value) {
+            size_t digits = j;
+            value = 0;
+            while (j < regex.length() && isdigit(regex[j])) {
+                value = std::min(value * 10 + (regex[j++] - '0'), MAX_REPEAT + 1);
+            }
+            return j > digits;
+        };
+        
+        if (!number(min)) return false;
+        max = min;
+        if (j < regex.length() && regex[j] == ',') {
+            j++;
+            if (!number(max)) max = -1;
+        }
+        if (j >= regex.length() || regex[j] != '}') return false;
+        
+        if (min > MAX_REPEAT || max > MAX_REPEAT || (max >= 0 && max < min)) {
+            throw std::runtime_error("invalid repetition count in " + regex);
+        }
+        i = j;
+        return true;
+    }
+    
+    // x{min,max} as min copies of x, then max - min optional copies, or a
+    // plus (star if min is 0) over the last copy when max is unbounded.
+    int repeat(RegexAST& ast, int node, int min, int max) {
+        if (max == 0) return ast.add(RegexNode::EMPTY);
+        
+        int result = -1;
+        int copies = max < 0 ? std::max(min, 1) : max;
+        for (int k = 0; k < copies; k++) {
+            int copy = k == 0 ? node : copySubtree(ast, node);
+            if (max < 0 && k == copies - 1) {
+                copy = ast.add(min == 0 ? RegexNode::STAR : RegexNode::PLUS, 0, copy);
+            } else if (k >= min) {
+                copy = ast.add(RegexNode::QUEST, 0, copy);
+            }
+            result = result < 0 ? copy : ast.add(RegexNode::CONCAT, 0, result, copy);
+        }
+        return result;
+    }
+    
+    // A subtree occupies the contiguous index range from its leftmost leaf
+    // to its root, so copying that range (shifting child indices) keeps
+    // nodes in post-order.
+    int copySubtree(RegexAST& ast, int node) {
+        int first = node;
+        while (ast.hasOperand(first)) first = ast.nodes[first].left;
+        int offset = ast.nodes.size() - first;
+        if (ast.nodes.size() + (node - first + 1) > MAX_NODES) {
+            throw std::runtime_error("regex too large once repetitions are expanded");
+        }
+        for (int i = first; i <= node; i++) {
+            RegexNode copy = ast.nodes[i];
+            if (ast.hasOperand(i)) {
+                copy.left += offset;
+                if (copy.right >= 0) copy.right += offset;
+            }
+            ast.nodes.push_back(copy);
+        }
+        return node + offset;
+    }
+    
+    int precedence(char op) {
+        if (op == '|') return 1;
+        if (op == '.') return 2;
+        return 0;
+    }
+    
+    void pushOperator(char op, RegexAST& ast, std::stack<char>& opStack, std::stack<int>& nodeStack) {
+        while (!opStack.empty() && opStack.top() != '(' &&
+               precedence(opStack.top()) >= precedence(op)) {
+            processOperator(opStack.top(), ast, nodeStack);
+            opStack.pop();
+        }
+        opStack.push(op);
+    }
+    
+    void processOperator(char op, RegexAST& ast, std::stack<int>& nodeStack) {
+        if (nodeStack.size() < 2) return;
+        
+        int right = nodeStack.top(); nodeStack.pop();
+        int left = nodeStack.top(); nodeStack.pop();
+        nodeStack.push(ast.add(op == '|' ? RegexNode::ALT : RegexNode::CONCAT, 0, left, right));
+    }
+    
+    // Literal analysis in post-order. Strings are capped at
+    // Literals::MAX_LENGTH; a shortened prefix, suffix or factor is still
+    // a valid one.
+    Literals literalsOf(const RegexAST& ast) {
+        auto begin = std::chrono::steady_clock::now();
+        std::vector<Literals> info(ast.nodes.size());
+        for (size_t i = 0; i < ast.nodes.size(); i++) {
+            const RegexNode& node = ast.nodes[i];
+            Literals& lit = info[i];
+            switch (node.kind) {
+            case RegexNode::EMPTY:
+                lit.exact = true;
+                break;
+            case RegexNode::CHAR:
+                lit.prefix = lit.suffix = lit.required = std::string(1, node.symbol);
+                lit.exact = true;
+                lit.maxLength = 1;
+                break;
+            case RegexNode::CONCAT:
+                lit = concatLiterals(info[node.left], info[node.right]);
+                break;
+            case RegexNode::ALT:
+                lit = altLiterals(info[node.left], info[node.right]);
+                break;
+            case RegexNode::CLASS: {
+                const std::vector<ByteRange>& ranges = ast.classes[node.left];
+                if (ranges.size() == 1 && ranges[0].lo == ranges[0].hi) {
+                    lit.prefix = lit.suffix = lit.required = std::string(1, (char)ranges[0].lo);
+                    lit.exact = true;
+                }
+                lit.maxLength = 1;
+                break;
+            }
+            case RegexNode::STAR:
+                // Zero repetitions match the empty string, so nothing is
+                // required; only a star over the empty string is bounded.
+                lit.exact = info[node.left].maxLength == 0;
+                lit.maxLength = lit.exact ? 0 : Literals::UNBOUNDED;
+                break;
+            case RegexNode::PLUS: {
+                // Every match starts and ends with a repetition of the operand
+                const Literals& once = info[node.left];
+                lit.prefix = once.prefix;
+                lit.suffix = once.suffix;
+                lit.required = once.required;
+                lit.exact = once.maxLength == 0;
+                lit.maxLength = lit.exact ? 0 : Literals::UNBOUNDED;
+                break;
+            }
+            case RegexNode::QUEST:
+                lit.exact = info[node.left].maxLength == 0;
+                lit.maxLength = info[node.left].maxLength;
+                break;
+            }
+        }
+        lastStats.literalMs += millisecondsSince(begin);
+        return info[ast.root];
+    }
+    
+    Literals concatLiterals(const Literals& a, const Literals& b) {
+        Literals lit;
+        lit.exact = a.exact && b.exact && a.prefix.size() + b.prefix.size() <= Literals::MAX_LENGTH;
+        lit.prefix = capFront(a.exact ? a.prefix + b.prefix : a.prefix);
+        lit.suffix = capBack(b.exact ? a.suffix + b.suffix : b.suffix);
+        lit.maxLength = (a.maxLength == Literals::UNBOUNDED || b.maxLength == Literals::UNBOUNDED)
+            ? Literals::UNBOUNDED : a.maxLength + b.maxLength;
+        
+        // a's suffix and b's prefix are adjacent in every match
+        lit.required = capFront(a.suffix + b.prefix);
+        keepLonger(lit.required, a.required);
+        keepLonger(lit.required, b.required);
+        keepLonger(lit.required, lit.prefix);
+        keepLonger(lit.required, lit.suffix);
+        return lit;
+    }
+    
+    Literals altLiterals(const Literals& a, const Literals& b) {
+        Literals lit;
+        size_t n = 0;
+        while (n < a.prefix.size() && n < b.prefix.size() && a.prefix[n] == b.prefix[n]) n++;
+        lit.prefix = a.prefix.substr(0, n);
+        n = 0;
+        while (n < a.suffix.size() && n < b.suffix.size() &&
+               a.suffix[a.suffix.size() - 1 - n] == b.suffix[b.suffix.size() - 1 - n]) n++;
+        lit.suffix = a.suffix.substr(a.suffix.size() - n);
+        lit.exact = a.exact && b.exact && a.prefix == b.prefix;
+        lit.maxLength = std::max(a.maxLength, b.maxLength);
+        
+        // Any common substring of both factors appears in every match
+        lit.required = longestCommonSubstring(a.required, b.required);
+        keepLonger(lit.required, lit.prefix);
+        keepLonger(lit.required, lit.suffix);
+        return lit;
+    }
+    
+    static void keepLonger(std::string& best, const std::string& candidate) {
+        if (candidate.size() > best.size()) best = candidate;
+    }
+    
+    static std::string capFront(const std::string& str) {
+        return str.size() > Literals::MAX_LENGTH ? str.substr(0, Literals::MAX_LENGTH) : str;
+    }
+    
+    static std::string capBack(const std::string& str) {
+        return str.size() > Literals::MAX_LENGTH ? str.substr(str.size() - Literals::MAX_LENGTH) : str;
+    }
+    
+    static std::string longestCommonSubstring(const std::string& a, const std::string& b) {
+        size_t bestLength = 0, bestEnd = 0;
+        std::vector<size_t> previous(b.size() + 1, 0), current(b.size() + 1, 0);
+        for (size_t i = 1; i <= a.size(); i++) {
+            for (size_t j = 1; j <= b.size(); j++) {
+                current[j] = a[i - 1] == b[j - 1] ? previous[j - 1] + 1 : 0;
+                if (current[j] > bestLength) {
+                    bestLength = current[j];
+                    bestEnd = i;
+                }
+            }
+            std::swap(previous, current);
+        }
+        return a.substr(bestEnd - bestLength, bestLength);
+    }
+    
+public:
+    // Close over epsilon edges once per NFA state up front instead of
+    // re-running the search for every (DFA state, symbol) pair.
+    bool precomputeClosures = true;
+    
+    // When set (and larger than one thread), subset construction expands
+    // each BFS level on the pool; the result is identical to the serial path.
+    ThreadPool* pool = nullptr;
+    
+    // The Thompson NFA convert() would determinize
+    NFA toNFA(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        return parseRegex(regex);
+    }
+    
+    // Phase timings and sizes from the most recent call below
+    const ConvertStats& stats() const { return lastStats; }
+    
+    // Skips subset construction entirely; states are built during matching.
+    LazyDFA convertLazy(const std::string& regex, size_t maxCacheBytes = 1 << 20) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        return LazyDFA(parseRegex(regex), maxCacheBytes);
+    }
+    
+    // Glushkov automaton simulated on bit masks; check fits() before use,
+    // since regexes with more than 64 positions are rejected.
+    BitParallelNFA convertBitParallel(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        return BitParallelNFA(parse(regex));
+    }
+    
+    // Thompson NFA run as is, with no determinization at all
+    NFASimulation convertSimulation(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        return NFASimulation(parseRegex(regex));
+    }
+    
+    // Hard cap on every subset construction below. convert() throws
+    // DFABudgetExceeded when it is hit; convertAuto() falls back instead.
+    DFABudget budget;
+    
+    // convertAuto() builds a full DFA only if subset construction stays
+    // within this many states.
+    size_t autoMaxStates = 4096;
+    
+    // Picks the engine per pattern: a minimized DFA when it is small
+    // enough, else the bit-parallel NFA when the regex has at most 64
+    // positions, else a lazy DFA. With a budget set, the last fallback is
+    // the NFA simulation instead, since the lazy DFA keeps allocating
+    // states while it matches.
+    Matcher convertAuto(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        RegexAST ast = parse(regex);
+        NFA nfa = thompson(ast);
+        
+        DFA dfa;
+        if (tryDeterminize(nfa, 1, autoMaxStates, dfa)) {
+            dfa.prefilter = Prefilter(literalsOf(ast));
+            return Matcher(dfa.minimize());
+        }
+        if (BitParallelNFA::countPositions(ast) <= BitParallelNFA::MAX_POSITIONS) {
+            return Matcher(BitParallelNFA(ast));
+        }
+        if (budget.limited()) return Matcher(NFASimulation(nfa));
+        return Matcher(LazyDFA(nfa));
+    }
+    
+    DFA convert(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        RegexAST ast = parse(regex);
+        DFA dfa = determinize(thompson(ast), 1);
+        dfa.prefilter = Prefilter(literalsOf(ast));
+        return dfa;
+    }
+    
+    // convert() plus the reverse DFA that find() and findAll() use to
+    // locate match starts without trying every position
+    DFA convertSearch(const std::string& regex) {
+        lastStats = ConvertStats();
+        this->regex = regex;
+        RegexAST ast = parse(regex);
+        NFA nfa = thompson(ast);
+        DFA reverseDFA = determinize(nfa.reversed(true), 1).minimize();
+        DFA dfa = determinize(nfa, 1);
+        dfa.prefilter = Prefilter(literalsOf(ast));
+        dfa.reverseDFA = std::make_shared<const DFA>(std::move(reverseDFA));
+        return dfa;
+    }
+    
+    // Combined automaton for several patterns; DFA::matches() reports the
+    // ids (indices into patterns) of every pattern matching the input.
+    DFA convert(const std::vector<std::string>& patterns) {
+        lastStats = ConvertStats();
+        this->regex.clear();
+        std::vector<RegexAST> asts;
+        Literals literals;
+        for (size_t i = 0; i < patterns.size(); i++) {
+            asts.push_back(parse(patterns[i]));
+            Literals next = literalsOf(asts.back());
+            literals = i == 0 ? next : altLiterals(literals, next);
+        }
+        DFA dfa = determinize(thompson(asts), patterns.size());
+        dfa.prefilter = Prefilter(literals);
+        return dfa;
+    }
+    
+private:
+    DFA determinize(const NFA& nfa, int numPatterns) {
+        DFA dfa;
+        if (!tryDeterminize(nfa, numPatterns, SIZE_MAX, dfa)) {
+            throw DFABudgetExceeded("DFA budget exceeded after " + std::to_string(lastStats.dfaStates)
+                                    + " states (about " + std::to_string(lastStats.dfaBytes) + " bytes)");
+        }
+        return dfa;
+    }
+    
+    // Subset construction that gives up (returning false, with dfa only
+    // partly built) once more than maxStates states have been discovered,
+    // or more than budget allows.
+    bool tryDeterminize(const NFA& nfa, int numPatterns, size_t maxStates, DFA& dfa) {
+        dfa.alphabet = nfa.alphabet;
+        dfa.numPatterns = numPatterns;
+        
+        ByteClasses classes(nfa);
+        dfa.setClasses(classes.classOf, classes.count());
+        
+        // Each set is stored twice (dfaStates and the stateMap key)
+        const size_t NODE = 32;
+        size_t setBytes = sizeof(StateSet) + StateSet(nfa.states.size()).words.size() * sizeof(uint64_t);
+        size_t stateBytes = 2 * setBytes + NODE + sizeof(int) + dfa.rowStride() * sizeof(int32_t)
+            + sizeof(std::vector<int>) + sizeof(void*);
+        if (budget.maxStates) maxStates = std::min(maxStates, budget.maxStates);
+        if (budget.maxBytes) maxStates = std::min(maxStates, budget.maxBytes / stateBytes);
+        
+        StateSet acceptMask(nfa.states.size());
+        for (int s : nfa.acceptStates) acceptMask.insert(s);
+        
+        auto begin = std::chrono::steady_clock::now();
+        EpsilonClosures closures;
+        if (precomputeClosures) {
+            closures = EpsilonClosures(nfa);
+            lastStats.closureBytes = closures.sccOf.size() * sizeof(int);
+            for (const StateSet& set : closures.sccClosure) {
+                lastStats.closureBytes += sizeof(StateSet) + set.words.size() * sizeof(uint64_t);
+            }
+        }
+        lastStats.closureMs += millisecondsSince(begin);
+        begin = std::chrono::steady_clock::now();
+        
+        // Called on every exit, including when maxStates is exceeded
+        auto record = [&]() {
+            lastStats.subsetMs += millisecondsSince(begin);
+            lastStats.dfaStates = dfa.dfaStates.size();
+            lastStats.hashCollisions = 0;
+            for (size_t b = 0; b < dfa.stateMap.bucket_count(); b++) {
+                size_t entries = dfa.stateMap.bucket_size(b);
+                if (entries > 1) lastStats.hashCollisions += entries - 1;
+            }
+            lastStats.dfaBytes = dfa.dfaStates.size() * (2 * setBytes + NODE + sizeof(int))
+                + dfa.stateMap.bucket_count() * sizeof(void*)
+                + dfa.table.capacity() * sizeof(int32_t);
+            for (const std::vector<int>& ids : dfa.acceptIds) lastStats.dfaBytes += sizeof(ids) + ids.size() * sizeof(int);
+        };
+        
+        StateSet start(nfa.states.size());
+        start.insert(nfa.startState);
+        StateSet startClosure = precomputeClosures ? closures.of(nfa.startState) : epsilonClosure(start, nfa);
+        
+        auto successor = [&](const StateSet& current, char symbol) {
+            return precomputeClosures
+                ? closures.step(current, symbol, nfa)
+                : epsilonClosure(move(current, symbol, nfa), nfa);
+        };
+        
+        auto intern = [&](StateSet&& set) {
+            auto inserted = dfa.stateMap.emplace(set, (int)dfa.dfaStates.size());
+            if (inserted.second) {
+                int newStateId = inserted.first->second;
+                dfa.dfaStates.push_back(std::move(set));
+                dfa.addRow();
+                dfa.acceptIds.push_back(acceptIdsOf(dfa.dfaStates.back(), acceptMask, nfa));
+                if (!dfa.acceptIds.back().empty()) {
+                    dfa.acceptStates.insert(newStateId);
+                }
+            }
+            return inserted.first->second;
+        };
+        
+        dfa.startState = intern(std::move(startClosure));
+        lastStats.closureComputations = 1;
+        if (dfa.dfaStates.size() > maxStates) {
+            record();
+            return false;
+        }
+        
+        if (pool && pool->size() > 1) {
+            // Level-synchronous BFS. Workers compute the successors of one
+            // level in parallel against a read-only stateMap; new sets are
+            // then interned serially in (state, class) order, which is
+            // exactly the order the serial loop below discovers them in, so
+            // both paths number states identically.
+            size_t k = classes.count();
+            const int UNINTERNED = -2;
+            std::vector<int> successorIds;
+            std::vector<StateSet> successorSets;
+            
+            for (size_t levelBegin = 0; levelBegin < dfa.dfaStates.size();) {
+                size_t levelEnd = dfa.dfaStates.size();
+                // A slice of n states discovers at most n * k new sets, so
+                // the level is cut to what the budget still allows instead
+                // of holding all of its successor sets at once
+                for (size_t sliceBegin = levelBegin; sliceBegin < levelEnd;) {
+                    size_t remaining = maxStates - dfa.dfaStates.size() + 1;
+                    size_t sliceSize = std::min(levelEnd - sliceBegin, std::max<size_t>(1, remaining / k));
+                    successorIds.assign(sliceSize * k, DFA::DEAD_STATE);
+                    successorSets.assign(sliceSize * k, StateSet());
+                    
+                    lastStats.closureComputations += sliceSize * k;
+                    pool->parallelFor(sliceSize, [&](size_t i) {
+                        const StateSet& current = dfa.dfaStates[sliceBegin + i];
+                        for (size_t a = 0; a < k; a++) {
+                            StateSet next = successor(current, (char)classes.representative[a]);
+                            if (next.empty()) continue;
+                            auto it = dfa.stateMap.find(next);
+                            if (it != dfa.stateMap.end()) {
+                                successorIds[i * k + a] = it->second;
+                            } else {
+                                successorIds[i * k + a] = UNINTERNED;
+                                successorSets[i * k + a] = std::move(next);
+                            }
+                        }
+                    });
+                    
+                    for (size_t i = 0; i < sliceSize; i++) {
+                        for (size_t a = 0; a < k; a++) {
+                            int id = successorIds[i * k + a];
+                            if (id == DFA::DEAD_STATE) continue;
+                            lastStats.internLookups++;
+                            if (id == UNINTERNED) id = intern(std::move(successorSets[i * k + a]));
+                            dfa.next(sliceBegin + i, a) = id;
+                            if (dfa.dfaStates.size() > maxStates) {
+                                record();
+                                return false;
+                            }
+                        }
+                    }
+                    sliceBegin += sliceSize;
+                }
+                levelBegin = levelEnd;
+            }
+        } else {
+            // dfaStates doubles as the unmarked queue: states are discovered
+            // in id order, so everything past currentDFAState is unmarked.
+            for (size_t currentDFAState = 0; currentDFAState < dfa.dfaStates.size(); currentDFAState++) {
+                StateSet current = dfa.dfaStates[currentDFAState];
+                
+                lastStats.closureComputations += classes.count();
+                for (int a = 0; a < classes.count(); a++) {
+                    StateSet nextClosure = successor(current, (char)classes.representative[a]);
+                    if (!nextClosure.empty()) {
+                        lastStats.internLookups++;
+                        int id = intern(std::move(nextClosure));
+                        dfa.next(currentDFAState, a) = id;
+                        if (dfa.dfaStates.size() > maxStates) {
+                            record();
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        
+        dfa.freeze();
+        record();
+        return true;
+    }
+    
+    std::vector<int> acceptIdsOf(const StateSet& states, const StateSet& acceptMask, const NFA& nfa) {
+        std::vector<int> ids;
+        for (size_t i = 0; i < states.words.size(); i++) {
+            uint64_t w = states.words[i] & acceptMask.words[i];
+            while (w) {
+                ids.push_back(nfa.states[i * 64 + __builtin_ctzll(w)].matchId);
+                w &= w - 1;
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        return ids;
+    }
+};
+
+struct Token {
+    int kind;
+    size_t offset;
+    size_t length;
+};
+
+// Maximal-munch tokenizer generated from an ordered list of (kind, regex)
+// rules, which share one multi-pattern DFA with rule i as pattern i. From
+// each position the DFA runs until it dies; the token is the longest
+// non-empty prefix any rule accepts, and the earliest such rule gives its
+// kind. Rules of kind SKIP consume input (whitespace, comments) without
+// producing tokens, and a byte no rule matches becomes a one-byte
+// UNMATCHED token.
+class Lexer {
+public:
+    static constexpr int SKIP = -1;
+    static constexpr int UNMATCHED = -2;
+    
+    // Throws runtime_error if a regex is malformed
+    explicit Lexer(const std::vector<std::pair<int, std::string>>& rules) {
+        std::vector<std::string> patterns;
+        for (const auto& rule : rules) {
+            kinds.push_back(rule.first);
+            patterns.push_back(rule.second);
+        }
+        RegexToDFA converter;
+        dfa = converter.convert(patterns).minimize();
+        
+        ruleOf.assign(dfa.dfaStates.size(), -1);
+        for (size_t s = 0; s < ruleOf.size(); s++) {
+            DFA::IdRange ids = dfa.matchIds(s);
+            if (!ids.empty()) ruleOf[s] = *ids.begin();
+        }
+    }
+    
+    // Appends the tokens of input and returns how many were added. A
+    // vector reused across calls stops allocating once it has grown.
+    size_t tokenize(std::string_view input, std::vector<Token>& tokens) const {
+        const int32_t* next = dfa.table.data();
+        const uint8_t* classOf = dfa.classMap.data();
+        const unsigned char* bytes = (const unsigned char*)input.data();
+        int shift = dfa.classShift;
+        size_t before = tokens.size();
+        
+        for (size_t pos = 0; pos < input.size();) {
+            int32_t state = dfa.startState;
+            int rule = -1;
+            size_t length = 1;
+            for (size_t i = pos; i < input.size(); i++) {
+                state = next[((size_t)state << shift) + classOf[bytes[i]]];
+                if (state == DFA::DEAD_STATE) break;
+                if (ruleOf[state] >= 0) {
+                    rule = ruleOf[state];
+                    length = i + 1 - pos;
+                }
+            }
+            
+            int kind = rule < 0 ? UNMATCHED : kinds[rule];
+            if (kind != SKIP) tokens.push_back({kind, pos, length});
+            pos += length;
+        }
+        return tokens.size() - before;
+    }
+    
+    std::vector<Token> tokenize(std::string_view input) const {
+        std::vector<Token> tokens;
+        tokenize(input, tokens);
+        return tokens;
+    }
+    
+    size_t states() const { return dfa.dfaStates.size(); }
+    
+private:
+    DFA dfa;
+    std::vector<int> kinds;   // per rule
+    std::vector<int> ruleOf;  // per DFA state: earliest accepting rule, or -1
+};
+
+#if __cplusplus >= 202002L
+// Compile-time version of the Thompson + subset construction pipeline, for
+// patterns known at build time: static_match<"(a|b)*abb">(input). The
+// compiler builds the NFA and DFA in fixed-capacity arrays and bakes the
+// exact-size transition table into the binary, so there is no startup cost.
+// Supports the basic subset of parseRegex's syntax: alphanumerics, '|',
+// '*', '+', '?' and parentheses. Any other character in the pattern is a
+// compile error rather than being skipped.
+template <size_t N>
+struct FixedString {
+    char chars[N] = {};
+    
+    constexpr FixedString(const char (&str)[N]) {
+        for (size_t i = 0; i < N; i++) chars[i] = str[i];
+    }
+    
+    constexpr size_t size() const { return N - 1; }
+};
+
+namespace static_regex {
+
+constexpr size_t MAX_DFA_STATES = 128;
+
+constexpr bool isSymbol(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+constexpr bool isSupported(char c) {
+    return isSymbol(c) || c == '|' || c == '*' || c == '+' || c == '?' || c == '(' || c == ')';
+}
+
+template <FixedString Pattern>
+constexpr bool supportedSyntax() {
+    for (size_t i = 0; i < Pattern.size(); i++) {
+        if (!isSupported(Pattern.chars[i])) return false;
+    }
+    return true;
+}
+
+// Thompson states have at most one symbol edge and two epsilon edges
+template <size_t MaxStates>
+struct NFA {
+    char symbol[MaxStates] = {};
+    int symbolTarget[MaxStates] = {};
+    int eps[MaxStates][2] = {};
+    int numEps[MaxStates] = {};
+    int numStates = 0;
+    int start = 0;
+    int accept = 0;
+    
+    constexpr int addState() { return numStates++; }
+    constexpr void addEpsilon(int from, int to) { eps[from][numEps[from]++] = to; }
+};
+
+template <FixedString Pattern>
+constexpr auto buildNFA() {
+    constexpr size_t length = Pattern.size();
+    NFA<2 * length + 2> nfa;
+    Fragment frags[length + 1] = {};
+    char ops[length + 1] = {};
+    int fragTop = 0, opTop = 0;
+    bool needConcat = false;
+    
+    auto precedence = [](char op) { return op == '|' ? 1 : op == '.' ? 2 : 0; };
+    auto apply = [&](char op) {
+        if (fragTop < 2) return;
+        Fragment frag2 = frags[--fragTop];
+        Fragment frag1 = frags[--fragTop];
+        if (op == '|') {
+            int start = nfa.addState(), end = nfa.addState();
+            nfa.addEpsilon(start, frag1.start);
+            nfa.addEpsilon(start, frag2.start);
+            nfa.addEpsilon(frag1.accept, end);
+            nfa.addEpsilon(frag2.accept, end);
+            frags[fragTop++] = {start, end};
+        } else {
+            nfa.addEpsilon(frag1.accept, frag2.start);
+            frags[fragTop++] = {frag1.start, frag2.accept};
+        }
+    };
+    auto pushOperator = [&](char op) {
+        while (opTop > 0 && ops[opTop - 1] != '(' && precedence(ops[opTop - 1]) >= precedence(op)) {
+            apply(ops[--opTop]);
+        }
+        ops[opTop++] = op;
+    };
+    
+    for (size_t i = 0; i < length; i++) {
+        char c = Pattern.chars[i];
+        if (isSymbol(c)) {
+            if (needConcat) pushOperator('.');
+            int start = nfa.addState(), end = nfa.addState();
+            nfa.symbol[start] = c;
+            nfa.symbolTarget[start] = end;
+            frags[fragTop++] = {start, end};
+            needConcat = true;
+        } else if (c == '(') {
+            if (needConcat) pushOperator('.');
+            ops[opTop++] = c;
+            needConcat = false;
+        } else if (c == ')') {
+            while (opTop > 0 && ops[opTop - 1] != '(') apply(ops[--opTop]);
+            if (opTop > 0) opTop--;
+            needConcat = true;
+        } else if (c == '|') {
+            pushOperator('|');
+            needConcat = false;
+        } else if ((c == '*' || c == '+' || c == '?') && fragTop > 0) {
+            Fragment frag = frags[fragTop - 1];
+            int start = nfa.addState(), end = nfa.addState();
+            nfa.addEpsilon(start, frag.start);
+            if (c != '+') nfa.addEpsilon(start, end);
+            nfa.addEpsilon(frag.accept, end);
+            if (c != '?') nfa.addEpsilon(frag.accept, frag.start);
+            frags[fragTop - 1] = {start, end};
+        }
+    }
+    while (opTop > 0) apply(ops[--opTop]);
+    
+    if (fragTop == 0) {
+        int start = nfa.addState(), end = nfa.addState();
+        nfa.addEpsilon(start, end);
+        frags[fragTop++] = {start, end};
+    }
+    nfa.start = frags[fragTop - 1].start;
+    nfa.accept = frags[fragTop - 1].accept;
+    return nfa;
+}
+
+// Subset construction into MAX_DFA_STATES rows over the pattern's alphabet
+template <size_t Words, size_t MaxSymbols>
+struct DFABuild {
+    std::array<uint64_t, Words> sets[MAX_DFA_STATES] = {};
+    int next[MAX_DFA_STATES][MaxSymbols] = {};
+    bool accept[MAX_DFA_STATES] = {};
+    char symbols[MaxSymbols] = {};
+    size_t numSymbols = 0;
+    size_t numStates = 0;
+    bool overflow = false;
+};
+
+template <FixedString Pattern>
+constexpr auto buildDFA() {
+    constexpr auto nfa = buildNFA<Pattern>();
+    constexpr size_t maxStates = 2 * Pattern.size() + 2;
+    constexpr size_t words = (maxStates + 63) / 64;
+    using Set = std::array<uint64_t, words>;
+    
+    DFABuild<words, Pattern.size() + 1> dfa;
+    for (int s = 0; s < nfa.numStates; s++) {
+        char c = nfa.symbol[s];
+        bool seen = c == '\0';
+        for (size_t a = 0; a < dfa.numSymbols && !seen; a++) seen = dfa.symbols[a] == c;
+        if (!seen) dfa.symbols[dfa.numSymbols++] = c;
+    }
+    
+    auto closeOver = [&](Set& set) {
+        int stack[maxStates] = {};
+        int top = 0;
+        for (int s = 0; s < nfa.numStates; s++) {
+            if ((set[s / 64] >> (s % 64)) & 1) stack[top++] = s;
+        }
+        while (top > 0) {
+            int s = stack[--top];
+            for (int e = 0; e < nfa.numEps[s]; e++) {
+                int t = nfa.eps[s][e];
+                if (!((set[t / 64] >> (t % 64)) & 1)) {
+                    set[t / 64] |= uint64_t(1) << (t % 64);
+                    stack[top++] = t;
+                }
+            }
+        }
+    };
+    auto intern = [&](const Set& set) {
+        for (size_t d = 0; d < dfa.numStates; d++) {
+            if (dfa.sets[d] == set) return (int)d;
+        }
+        if (dfa.numStates == MAX_DFA_STATES) {
+            dfa.overflow = true;
+            return 0;
+        }
+        dfa.sets[dfa.numStates] = set;
+        dfa.accept[dfa.numStates] = (set[nfa.accept / 64] >> (nfa.accept % 64)) & 1;
+        return (int)dfa.numStates++;
+    };
+    
+    Set start = {};
+    start[nfa.start / 64] |= uint64_t(1) << (nfa.start % 64);
+    closeOver(start);
+    intern(start);
+    
+    for (size_t d = 0; d < dfa.numStates && !dfa.overflow; d++) {
+        for (size_t a = 0; a < dfa.numSymbols; a++) {
+            Set moved = {};
+            bool any = false;
+            for (int s = 0; s < nfa.numStates; s++) {
+                if (((dfa.sets[d][s / 64] >> (s % 64)) & 1) && nfa.symbol[s] == dfa.symbols[a]) {
+                    int t = nfa.symbolTarget[s];
+                    moved[t / 64] |= uint64_t(1) << (t % 64);
+                    any = true;
+                }
+            }
+            if (!any) {
+                dfa.next[d][a] = DFA::DEAD_STATE;
+                continue;
+            }
+            closeOver(moved);
+            dfa.next[d][a] = intern(moved);
+        }
+    }
+    return dfa;
+}
+
+// Exact-size tables: symbolOf maps a byte to its alphabet column or -1
+template <size_t States, size_t Symbols>
+struct StaticDFA {
+    int32_t next[States][Symbols] = {};
+    bool accept[States] = {};
+    int16_t symbolOf[256] = {};
+    
+    constexpr bool match(std::string_view input) const {
+        int32_t state = 0;
+        for (char c : input) {
+            int16_t symbol = symbolOf[(unsigned char)c];
+            if (symbol < 0) return false;
+            state = next[state][symbol];
+            if (state == DFA::DEAD_STATE) return false;
+        }
+        return accept[state];
+    }
+};
+
+template <FixedString Pattern>
+constexpr auto compile() {
+    static_assert(supportedSyntax<Pattern>(),
+                  "static_match: only alphanumerics, '|', '*', '+', '?' and parentheses are supported");
+    constexpr auto build = buildDFA<Pattern>();
+    static_assert(!build.overflow, "static_match: DFA exceeds static_regex::MAX_DFA_STATES");
+    
+    StaticDFA<build.numStates, (build.numSymbols > 0 ? build.numSymbols : 1)> dfa;
+    for (int c = 0; c < 256; c++) dfa.symbolOf[c] = -1;
+    for (size_t a = 0; a < build.numSymbols; a++) {
+        dfa.symbolOf[(unsigned char)build.symbols[a]] = a;
+    }
+    for (size_t s = 0; s < build.numStates; s++) {
+        dfa.accept[s] = build.accept[s];
+        for (size_t a = 0; a < build.numSymbols; a++) dfa.next[s][a] = build.next[s][a];
+    }
+    return dfa;
+}
+
+template <FixedString Pattern>
+inline constexpr auto dfa = compile<Pattern>();
+
+}  // namespace static_regex
+
+template <FixedString Pattern>
+constexpr bool static_match(std::string_view input) {
+    return static_regex::dfa<Pattern>.match(input);
+}
+#endif
+
+#endif